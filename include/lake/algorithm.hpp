@@ -0,0 +1,443 @@
+/*
+ * SPDX-FileCopyrightText: 2023 Max Wipfli <mail@maxwipfli.ch>
+ * SPDX-LicenseIdentifier: MIT
+ */
+
+#pragma once
+
+#include "extras.hpp"
+#include "span.hpp"
+#include "type_traits.hpp"
+#include "types.hpp"
+
+namespace lake {
+
+// The default comparison for sorting, using operator<.
+struct less {
+    template <typename T, typename U>
+    constexpr bool operator()(T const& first, U const& second) const
+    {
+        return first < second;
+    }
+};
+
+// Pattern-defeating quicksort (pdqsort, see https://arxiv.org/abs/2106.05123), which is an introsort with a few
+// improvements:
+//  - Small ranges are sorted by insertion sort.
+//  - Pivots are the median of three elements, or Tukey's ninther for larger ranges.
+//  - Ranges with many equal elements are partitioned in linear time.
+//  - Already partitioned ranges are detected, which makes sorted (and reverse sorted) inputs linear.
+//  - Bad pivots (leading to unbalanced partitions) are countered by shuffling elements, and if that keeps happening,
+//    the range is sorted by heapsort, which guarantees O(n log n) in the worst case.
+//
+// If `Branchless` is true, partitioning first records which elements are on the wrong side in blocks of offsets, and then
+// swaps them. This replaces a hard-to-predict branch per element with arithmetic, which is much faster for cheap
+// comparisons (e.g. of integers).
+template <typename T, typename Compare, bool Branchless>
+class pdq_sorter {
+public:
+    static void sort(T* begin, T* end, Compare& less)
+    {
+        if (end - begin < 2) {
+            return;
+        }
+        sort_loop(begin, end, less, 63 - __builtin_clzll(end - begin), true);
+    }
+
+private:
+    static constexpr ptrdiff_t insertion_sort_threshold = 24;
+    static constexpr ptrdiff_t ninther_threshold = 128;
+    // The number of element moves after which partial_insertion_sort() gives up.
+    static constexpr ptrdiff_t partial_insertion_sort_limit = 8;
+    // Offsets within a block are stored in a u8.
+    static constexpr ptrdiff_t block_size = 64;
+
+    struct partition_result {
+        T* pivot;
+        bool already_partitioned;
+    };
+
+    static void sort_loop(T* begin, T* end, Compare& less, int bad_allowed, bool leftmost)
+    {
+        while (true) {
+            auto size = end - begin;
+            if (size < insertion_sort_threshold) {
+                if (leftmost) {
+                    insertion_sort(begin, end, less);
+                } else {
+                    unguarded_insertion_sort(begin, end, less);
+                }
+                return;
+            }
+
+            // Move the pivot to *begin.
+            auto half = size / 2;
+            if (size > ninther_threshold) {
+                sort3(begin, begin + half, end - 1, less);
+                sort3(begin + 1, begin + (half - 1), end - 2, less);
+                sort3(begin + 2, begin + (half + 1), end - 3, less);
+                sort3(begin + (half - 1), begin + half, begin + (half + 1), less);
+                swap(*begin, *(begin + half));
+            } else {
+                sort3(begin + half, begin, end - 1, less);
+            }
+
+            // If this is not the leftmost range, *(begin - 1) is the pivot of a previous partitioning, so no element of
+            // this range is less than it. If the new pivot is equal to it, all elements equal to the pivot are put into
+            // the left partition, which is then done, as all of its elements are equal. This makes sorting ranges with
+            // many equal elements linear.
+            if (!leftmost && !less(*(begin - 1), *begin)) {
+                begin = partition_left(begin, end, less) + 1;
+                continue;
+            }
+
+            auto [pivot, already_partitioned] = Branchless ? partition_right_branchless(begin, end, less) : partition_right(begin, end, less);
+
+            auto left_size = pivot - begin;
+            auto right_size = end - (pivot + 1);
+            if (left_size < size / 8 || right_size < size / 8) {
+                // The partitions are highly unbalanced, so switch to heapsort if this happens too often.
+                if (--bad_allowed == 0) {
+                    heap_sort(begin, end, less);
+                    return;
+                }
+                // Otherwise, break patterns in the input which may have caused the bad pivot.
+                if (left_size >= insertion_sort_threshold) {
+                    swap(*begin, *(begin + left_size / 4));
+                    swap(*(pivot - 1), *(pivot - left_size / 4));
+                    if (left_size > ninther_threshold) {
+                        swap(*(begin + 1), *(begin + (left_size / 4 + 1)));
+                        swap(*(begin + 2), *(begin + (left_size / 4 + 2)));
+                        swap(*(pivot - 2), *(pivot - (left_size / 4 + 1)));
+                        swap(*(pivot - 3), *(pivot - (left_size / 4 + 2)));
+                    }
+                }
+                if (right_size >= insertion_sort_threshold) {
+                    swap(*(pivot + 1), *(pivot + (1 + right_size / 4)));
+                    swap(*(end - 1), *(end - right_size / 4));
+                    if (right_size > ninther_threshold) {
+                        swap(*(pivot + 2), *(pivot + (2 + right_size / 4)));
+                        swap(*(pivot + 3), *(pivot + (3 + right_size / 4)));
+                        swap(*(end - 2), *(end - (1 + right_size / 4)));
+                        swap(*(end - 3), *(end - (2 + right_size / 4)));
+                    }
+                }
+            } else if (already_partitioned && partial_insertion_sort(begin, pivot, less) && partial_insertion_sort(pivot + 1, end, less)) {
+                // The range was balanced and already partitioned, so it was likely (almost) sorted already.
+                return;
+            }
+
+            // Recurse into the left partition, and loop for the right one, which bounds the stack depth.
+            sort_loop(begin, pivot, less, bad_allowed, leftmost);
+            begin = pivot + 1;
+            leftmost = false;
+        }
+    }
+
+    static void sort2(T* first, T* second, Compare& less)
+    {
+        if (less(*second, *first)) {
+            swap(*first, *second);
+        }
+    }
+
+    static void sort3(T* first, T* second, T* third, Compare& less)
+    {
+        sort2(first, second, less);
+        sort2(second, third, less);
+        sort2(first, second, less);
+    }
+
+    static void insertion_sort(T* begin, T* end, Compare& less)
+    {
+        for (T* current = begin + 1; current < end; ++current) {
+            if (!less(*current, *(current - 1))) {
+                continue;
+            }
+            T value = move(*current);
+            T* hole = current;
+            do {
+                *hole = move(*(hole - 1));
+                --hole;
+            } while (hole != begin && less(value, *(hole - 1)));
+            *hole = move(value);
+        }
+    }
+
+    // Like insertion_sort(), but assumes that *(begin - 1) is not greater than any element of the range, which makes the
+    // bounds check unnecessary.
+    static void unguarded_insertion_sort(T* begin, T* end, Compare& less)
+    {
+        for (T* current = begin + 1; current < end; ++current) {
+            if (!less(*current, *(current - 1))) {
+                continue;
+            }
+            T value = move(*current);
+            T* hole = current;
+            do {
+                *hole = move(*(hole - 1));
+                --hole;
+            } while (less(value, *(hole - 1)));
+            *hole = move(value);
+        }
+    }
+
+    // Try to sort the range by insertion sort, but give up after a few moves. Returns whether the range is sorted.
+    static bool partial_insertion_sort(T* begin, T* end, Compare& less)
+    {
+        ptrdiff_t moves = 0;
+        for (T* current = begin + 1; current < end; ++current) {
+            if (!less(*current, *(current - 1))) {
+                continue;
+            }
+            T value = move(*current);
+            T* hole = current;
+            do {
+                *hole = move(*(hole - 1));
+                --hole;
+            } while (hole != begin && less(value, *(hole - 1)));
+            *hole = move(value);
+            moves += current - hole;
+            if (moves > partial_insertion_sort_limit) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    static void sift_down(T* heap, ptrdiff_t size, ptrdiff_t index, Compare& less)
+    {
+        T value = move(heap[index]);
+        while (true) {
+            auto child = 2 * index + 1;
+            if (child >= size) {
+                break;
+            }
+            if (child + 1 < size && less(heap[child], heap[child + 1])) {
+                ++child;
+            }
+            if (!less(value, heap[child])) {
+                break;
+            }
+            heap[index] = move(heap[child]);
+            index = child;
+        }
+        heap[index] = move(value);
+    }
+
+    static void heap_sort(T* begin, T* end, Compare& less)
+    {
+        auto size = end - begin;
+        for (auto index = size / 2; index-- > 0;) {
+            sift_down(begin, size, index, less);
+        }
+        for (auto last = size; last-- > 1;) {
+            swap(begin[0], begin[last]);
+            sift_down(begin, last, 0, less);
+        }
+    }
+
+    // Partition the range around the pivot *begin, with the elements equal to the pivot going to the right. The pivot is
+    // the median of three elements, so there is an element which is not less than it, which stops the first scan.
+    static partition_result partition_right(T* begin, T* end, Compare& less)
+    {
+        T pivot = move(*begin);
+        T* first = begin;
+        T* last = end;
+
+        while (less(*++first, pivot)) { }
+        // If this is the first element, there may not be an element less than the pivot to stop the scan.
+        if (first - 1 == begin) {
+            while (first < last && !less(*--last, pivot)) { }
+        } else {
+            while (!less(*--last, pivot)) { }
+        }
+
+        bool already_partitioned = first >= last;
+        while (first < last) {
+            swap(*first, *last);
+            while (less(*++first, pivot)) { }
+            while (!less(*--last, pivot)) { }
+        }
+
+        return place_pivot(begin, first - 1, move(pivot), already_partitioned);
+    }
+
+    // Like partition_right(), but the elements which are out of place are found in blocks without branching on the
+    // comparisons, and then swapped.
+    static partition_result partition_right_branchless(T* begin, T* end, Compare& less)
+    {
+        T pivot = move(*begin);
+        T* first = begin;
+        T* last = end;
+
+        while (less(*++first, pivot)) { }
+        if (first - 1 == begin) {
+            while (first < last && !less(*--last, pivot)) { }
+        } else {
+            while (!less(*--last, pivot)) { }
+        }
+
+        bool already_partitioned = first >= last;
+        if (!already_partitioned) {
+            swap(*first, *last);
+            ++first;
+
+            // Offsets of elements which belong on the other side: relative to left_base on the left, and to right_base
+            // (counting down) on the right.
+            alignas(64) u8 left_offsets[block_size];
+            alignas(64) u8 right_offsets[block_size];
+            T* left_base = first;
+            T* right_base = last;
+            ptrdiff_t left_count = 0;
+            ptrdiff_t right_count = 0;
+            ptrdiff_t left_start = 0;
+            ptrdiff_t right_start = 0;
+
+            while (first < last) {
+                // Fill the blocks which are empty, splitting the remaining elements if both of them are.
+                auto unknown = last - first;
+                auto left_split = left_count == 0 ? (right_count == 0 ? unknown / 2 : unknown) : 0;
+                auto right_split = right_count == 0 ? unknown - left_split : 0;
+                if (left_split > block_size) {
+                    left_split = block_size;
+                }
+                if (right_split > block_size) {
+                    right_split = block_size;
+                }
+
+                for (ptrdiff_t i = 0; i < left_split; ++i) {
+                    left_offsets[left_count] = static_cast<u8>(i);
+                    left_count += !less(*first, pivot);
+                    ++first;
+                }
+                for (ptrdiff_t i = 0; i < right_split; ++i) {
+                    right_offsets[right_count] = static_cast<u8>(i + 1);
+                    right_count += less(*--last, pivot);
+                }
+
+                // Swap as many pairs as possible. If both blocks are emptied, the elements can be moved in a cycle,
+                // which needs fewer moves than swapping them.
+                auto count = left_count < right_count ? left_count : right_count;
+                swap_offsets(left_base, right_base, left_offsets + left_start, right_offsets + right_start, count, left_count == right_count);
+                left_count -= count;
+                right_count -= count;
+                left_start += count;
+                right_start += count;
+
+                if (left_count == 0) {
+                    left_start = 0;
+                    left_base = first;
+                }
+                if (right_count == 0) {
+                    right_start = 0;
+                    right_base = last;
+                }
+            }
+
+            // At most one of the blocks still has elements, which are swapped towards the boundary.
+            if (left_count > 0) {
+                while (left_count-- > 0) {
+                    swap(*(left_base + left_offsets[left_start + left_count]), *--last);
+                }
+                first = last;
+            }
+            if (right_count > 0) {
+                while (right_count-- > 0) {
+                    swap(*(right_base - right_offsets[right_start + right_count]), *first);
+                    ++first;
+                }
+            }
+        }
+
+        return place_pivot(begin, first - 1, move(pivot), already_partitioned);
+    }
+
+    static void swap_offsets(T* left_base, T* right_base, u8 const* left_offsets, u8 const* right_offsets, ptrdiff_t count, bool use_swaps)
+    {
+        if (use_swaps) {
+            for (ptrdiff_t i = 0; i < count; ++i) {
+                swap(*(left_base + left_offsets[i]), *(right_base - right_offsets[i]));
+            }
+        } else if (count > 0) {
+            T* left = left_base + left_offsets[0];
+            T* right = right_base - right_offsets[0];
+            T tmp = move(*left);
+            *left = move(*right);
+            for (ptrdiff_t i = 1; i < count; ++i) {
+                left = left_base + left_offsets[i];
+                *right = move(*left);
+                right = right_base - right_offsets[i];
+                *left = move(*right);
+            }
+            *right = move(tmp);
+        }
+    }
+
+    // Partition the range around the pivot *begin, with the elements equal to the pivot going to the left.
+    static T* partition_left(T* begin, T* end, Compare& less)
+    {
+        T pivot = move(*begin);
+        T* first = begin;
+        T* last = end;
+
+        while (less(pivot, *--last)) { }
+        if (last + 1 == end) {
+            while (first < last && !less(pivot, *++first)) { }
+        } else {
+            while (!less(pivot, *++first)) { }
+        }
+
+        while (first < last) {
+            swap(*first, *last);
+            while (less(pivot, *--last)) { }
+            while (!less(pivot, *++first)) { }
+        }
+
+        return place_pivot(begin, last, move(pivot), false).pivot;
+    }
+
+    static partition_result place_pivot(T* begin, T* position, T&& pivot, bool already_partitioned)
+    {
+        *begin = move(*position);
+        *position = move(pivot);
+        return { position, already_partitioned };
+    }
+};
+
+// Sort the elements of `values` in place, such that `less(values[i + 1], values[i])` is false for all i. The sort is not
+// stable. `less` must be a strict weak ordering.
+template <typename T, typename Compare>
+void sort(span<T> values, Compare less)
+{
+    pdq_sorter<T, Compare, false>::sort(values.data(), values.data() + values.size(), less);
+}
+
+// Sort the elements of `values` in ascending order, using operator<.
+template <typename T>
+void sort(span<T> values)
+{
+    // Comparisons of arithmetic types and pointers are cheap, so block partitioning pays off.
+    constexpr bool branchless = is_arithmetic_v<T> || is_pointer_v<T>;
+    lake::less less;
+    pdq_sorter<T, lake::less, branchless>::sort(values.data(), values.data() + values.size(), less);
+}
+
+template <typename T, typename Compare>
+[[nodiscard]] bool is_sorted(span<T> values, Compare less)
+{
+    for (size_t i = 1; i < values.size(); ++i) {
+        if (less(values[i], values[i - 1])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+template <typename T>
+[[nodiscard]] bool is_sorted(span<T> values)
+{
+    return is_sorted(values, lake::less {});
+}
+
+}
@@ -0,0 +1,72 @@
+/*
+ * SPDX-FileCopyrightText: 2023 Max Wipfli <mail@maxwipfli.ch>
+ * SPDX-LicenseIdentifier: MIT
+ */
+
+#pragma once
+
+#include "type_traits.hpp"
+#include "types.hpp"
+#include <assert.h>
+#include <stdlib.h>
+
+namespace lake {
+
+// An allocator hands out raw, uninitialized memory. Containers store their allocator by value, so stateless allocators
+// take up no space, while stateful ones (e.g. a handle to an arena) are carried along with the container.
+//
+// deallocate() is always called with the same size and alignment that were passed to allocate().
+template <typename A>
+concept allocator = requires(A& a, void* ptr, size_t size, size_t alignment) {
+    { a.allocate(size, alignment) } -> same_as<void*>;
+    a.deallocate(ptr, size, alignment);
+};
+
+// Allocators may additionally support resizing an allocation, moving its contents as raw bytes if necessary. Containers
+// use this to grow buffers of trivially relocatable elements.
+template <typename A>
+concept reallocating_allocator = allocator<A> && requires(A& a, void* ptr, size_t old_size, size_t new_size, size_t alignment) {
+    { a.reallocate(ptr, old_size, new_size, alignment) } -> same_as<void*>;
+};
+
+// The default allocator, backed by the C heap.
+struct default_allocator {
+    // malloc() returns memory suitable for any fundamental type, which is the same guarantee `new` gives.
+    static constexpr size_t malloc_alignment = __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+
+    [[nodiscard]] void* allocate(size_t size, size_t alignment)
+    {
+        void* ptr;
+        if (alignment <= malloc_alignment) {
+            ptr = malloc(size);
+        } else {
+            // aligned_alloc() requires the size to be a multiple of the alignment.
+            ptr = aligned_alloc(alignment, (size + alignment - 1) & ~(alignment - 1));
+        }
+        assert(ptr != nullptr);
+        return ptr;
+    }
+
+    void deallocate(void* ptr, size_t, size_t)
+    {
+        free(ptr);
+    }
+
+    [[nodiscard]] void* reallocate(void* ptr, size_t old_size, size_t new_size, size_t alignment)
+    {
+        if (alignment > malloc_alignment) {
+            // realloc() does not preserve extended alignment.
+            auto* new_ptr = allocate(new_size, alignment);
+            __builtin_memcpy(new_ptr, ptr, old_size < new_size ? old_size : new_size);
+            free(ptr);
+            return new_ptr;
+        }
+        auto* new_ptr = realloc(ptr, new_size);
+        assert(new_ptr != nullptr);
+        return new_ptr;
+    }
+};
+
+static_assert(reallocating_allocator<default_allocator>);
+
+}
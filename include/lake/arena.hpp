@@ -0,0 +1,210 @@
+/*
+ * SPDX-FileCopyrightText: 2023 Max Wipfli <mail@maxwipfli.ch>
+ * SPDX-LicenseIdentifier: MIT
+ */
+
+#pragma once
+
+#include "allocator.hpp"
+#include "extras.hpp"
+#include "types.hpp"
+#include <assert.h>
+
+namespace lake {
+
+// A monotonic (bump-pointer) arena. Memory is taken from large chunks in O(1), individual deallocations are no-ops
+// (except for the most recent allocation, which is rolled back), and everything is released at once by reset() or when
+// the arena is destroyed.
+//
+// The arena itself is not an allocator, as containers store their allocator by value. Use arena_allocator (see below) to
+// construct containers in an arena.
+class arena {
+public:
+    static constexpr size_t default_chunk_size = 64 * 1024;
+
+    explicit arena(size_t chunk_size = default_chunk_size)
+        : m_chunk_size(chunk_size)
+    {
+        assert(chunk_size > sizeof(chunk));
+    }
+
+    ~arena()
+    {
+        release_chunks(nullptr);
+    }
+
+    arena(arena const&) = delete;
+    arena& operator=(arena const&) = delete;
+    arena(arena&&) = delete;
+    arena& operator=(arena&&) = delete;
+
+    [[nodiscard]] void* allocate(size_t size, size_t alignment)
+    {
+        assert(alignment != 0 && (alignment & (alignment - 1)) == 0);
+
+        auto* ptr = align_up(m_current, alignment);
+        if (ptr > m_end || size > static_cast<size_t>(m_end - ptr)) {
+            ptr = allocate_slow(size, alignment);
+        } else {
+            m_current = ptr + size;
+        }
+        // Padding for alignment is not accounted for.
+        add_bytes_used(size);
+        return ptr;
+    }
+
+    void deallocate(void* ptr, size_t size, size_t)
+    {
+        // Only the most recent allocation can be given back, everything else is kept until the arena is reset.
+        if (static_cast<u8*>(ptr) + size == m_current) {
+            m_current = static_cast<u8*>(ptr);
+        }
+        m_bytes_used -= size;
+    }
+
+    [[nodiscard]] void* reallocate(void* ptr, size_t old_size, size_t new_size, size_t alignment)
+    {
+        auto* bytes = static_cast<u8*>(ptr);
+        if (bytes + old_size == m_current && new_size <= static_cast<size_t>(m_end - bytes)) {
+            // This was the most recent allocation, so it can be resized in place.
+            m_current = bytes + new_size;
+            m_bytes_used -= old_size;
+            add_bytes_used(new_size);
+            return ptr;
+        }
+        auto* new_ptr = allocate(new_size, alignment);
+        __builtin_memcpy(new_ptr, ptr, old_size < new_size ? old_size : new_size);
+        m_bytes_used -= old_size;
+        return new_ptr;
+    }
+
+    // Release all allocations at once. The current chunk is kept around to be reused by the following allocations.
+    void reset()
+    {
+        if (m_chunks) {
+            release_chunks(m_chunks);
+            m_chunks->previous = nullptr;
+            m_current = m_chunks->data();
+            m_end = m_chunks->end();
+        }
+        m_bytes_used = 0;
+    }
+
+    [[nodiscard]] size_t chunk_size() const { return m_chunk_size; }
+    // The number of bytes currently allocated from the arena.
+    [[nodiscard]] size_t bytes_used() const { return m_bytes_used; }
+    // The maximum of bytes_used() over the lifetime of the arena, which is not affected by reset().
+    [[nodiscard]] size_t peak_bytes_used() const { return m_peak_bytes_used; }
+    // The number of bytes held by the arena's chunks.
+    [[nodiscard]] size_t bytes_reserved() const { return m_bytes_reserved; }
+
+private:
+    // Chunks form a singly-linked list, starting with the most recent one. The usable memory follows the header.
+    struct chunk {
+        chunk* previous;
+        size_t size;
+
+        [[nodiscard]] u8* data() { return reinterpret_cast<u8*>(this + 1); }
+        [[nodiscard]] u8* end() { return reinterpret_cast<u8*>(this) + size; }
+    };
+
+    static u8* align_up(u8* ptr, size_t alignment)
+    {
+        auto address = reinterpret_cast<uintptr_t>(ptr);
+        return reinterpret_cast<u8*>((address + alignment - 1) & ~(alignment - 1));
+    }
+
+    void add_bytes_used(size_t size)
+    {
+        m_bytes_used += size;
+        if (m_bytes_used > m_peak_bytes_used) {
+            m_peak_bytes_used = m_bytes_used;
+        }
+    }
+
+    u8* allocate_slow(size_t size, size_t alignment)
+    {
+        // The worst-case padding for alignment beyond that of the chunk header has to fit into the chunk as well.
+        auto needed = sizeof(chunk) + size + (alignment > alignof(chunk) ? alignment : 0);
+        if (needed > m_chunk_size / 4) {
+            // Large allocations get a dedicated chunk. It is placed behind the current chunk in the list, so that the
+            // remaining space in the current chunk can still be used.
+            auto* new_chunk = allocate_chunk(needed);
+            if (m_chunks) {
+                new_chunk->previous = m_chunks->previous;
+                m_chunks->previous = new_chunk;
+            } else {
+                new_chunk->previous = nullptr;
+                m_chunks = new_chunk;
+                m_current = m_end = new_chunk->end();
+            }
+            return align_up(new_chunk->data(), alignment);
+        }
+
+        auto* new_chunk = allocate_chunk(m_chunk_size);
+        new_chunk->previous = m_chunks;
+        m_chunks = new_chunk;
+        auto* ptr = align_up(new_chunk->data(), alignment);
+        m_current = ptr + size;
+        m_end = new_chunk->end();
+        return ptr;
+    }
+
+    chunk* allocate_chunk(size_t size)
+    {
+        auto* new_chunk = static_cast<chunk*>(default_allocator {}.allocate(size, alignof(chunk)));
+        new_chunk->size = size;
+        m_bytes_reserved += size;
+        return new_chunk;
+    }
+
+    // Free all chunks behind `keep` in the list, or all chunks if `keep` is null.
+    void release_chunks(chunk* keep)
+    {
+        auto* current = keep ? keep->previous : m_chunks;
+        while (current) {
+            auto* previous = current->previous;
+            m_bytes_reserved -= current->size;
+            default_allocator {}.deallocate(current, current->size, alignof(chunk));
+            current = previous;
+        }
+        if (!keep) {
+            m_chunks = nullptr;
+            m_current = m_end = nullptr;
+        }
+    }
+
+    chunk* m_chunks { nullptr };
+    u8* m_current { nullptr };
+    u8* m_end { nullptr };
+    size_t m_chunk_size;
+    size_t m_bytes_used { 0 };
+    size_t m_peak_bytes_used { 0 };
+    size_t m_bytes_reserved { 0 };
+};
+
+// A handle to an arena, which can be used as the allocator of lake containers. The arena must outlive all containers
+// using it.
+class arena_allocator {
+public:
+    explicit arena_allocator(arena& arena)
+        : m_arena(&arena)
+    {
+    }
+
+    [[nodiscard]] void* allocate(size_t size, size_t alignment) { return m_arena->allocate(size, alignment); }
+    void deallocate(void* ptr, size_t size, size_t alignment) { m_arena->deallocate(ptr, size, alignment); }
+    [[nodiscard]] void* reallocate(void* ptr, size_t old_size, size_t new_size, size_t alignment)
+    {
+        return m_arena->reallocate(ptr, old_size, new_size, alignment);
+    }
+
+    bool operator==(arena_allocator const& other) const { return m_arena == other.m_arena; }
+
+private:
+    lake::arena* m_arena;
+};
+
+static_assert(reallocating_allocator<arena_allocator>);
+
+}
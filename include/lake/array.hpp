@@ -35,7 +35,7 @@ struct array {
 
     // spans
     [[nodiscard]] constexpr ::lake::span<T> span() { return *this; }
-    [[nodiscard]] constexpr ::lake::span<T const> span() const { return *this; }
+    [[nodiscard]] constexpr ::lake::span<T const> span() const { return { data(), Size }; }
     [[nodiscard]] constexpr ::lake::span<T> subspan(size_t start, size_t size) { return span().subspan(start, size); }
     [[nodiscard]] constexpr ::lake::span<T const> subspan(size_t start, size_t size) const { return span().subspan(start, size); }
 
@@ -0,0 +1,153 @@
+/*
+ * SPDX-FileCopyrightText: 2023 Max Wipfli <mail@maxwipfli.ch>
+ * SPDX-LicenseIdentifier: MIT
+ */
+
+#pragma once
+
+#include "futex.hpp"
+#include "type_traits.hpp"
+#include "types.hpp"
+
+namespace lake {
+
+enum class memory_order : int {
+    relaxed = __ATOMIC_RELAXED,
+    acquire = __ATOMIC_ACQUIRE,
+    release = __ATOMIC_RELEASE,
+    acq_rel = __ATOMIC_ACQ_REL,
+    seq_cst = __ATOMIC_SEQ_CST,
+};
+
+// A value which can be accessed by multiple threads at the same time, implemented with the compiler's atomic builtins.
+//
+// Unlike with std::atomic, every operation takes its memory order explicitly, which keeps the synchronization of
+// concurrent code visible at each access.
+template <typename T>
+class atomic {
+    static_assert(__is_trivially_copyable(T), "atomic values must be trivially copyable");
+    static_assert(sizeof(T) == 1 || sizeof(T) == 2 || sizeof(T) == 4 || sizeof(T) == 8, "atomic values must be lock-free");
+
+public:
+    using difference_type = conditional_t<is_pointer_v<T>, ptrdiff_t, T>;
+
+    constexpr atomic() = default;
+
+    constexpr atomic(T value) // NOLINT(google-explicit-constructor)
+        : m_value(value)
+    {
+    }
+
+    atomic(atomic const&) = delete;
+    atomic& operator=(atomic const&) = delete;
+
+    [[nodiscard]] T load(memory_order order) const
+    {
+        T result;
+        __atomic_load(&m_value, &result, static_cast<int>(order));
+        return result;
+    }
+
+    void store(T value, memory_order order) { __atomic_store(&m_value, &value, static_cast<int>(order)); }
+
+    T exchange(T value, memory_order order)
+    {
+        T result;
+        __atomic_exchange(&m_value, &value, &result, static_cast<int>(order));
+        return result;
+    }
+
+    // Replace the value by `desired` if it is equal to `expected`, and return true. Otherwise, `expected` is set to the
+    // current value. The weak variant may fail spuriously, which is cheaper on some architectures when used in a loop.
+    bool compare_exchange_strong(T& expected, T desired, memory_order success, memory_order failure)
+    {
+        return __atomic_compare_exchange(&m_value, &expected, &desired, false, static_cast<int>(success), static_cast<int>(failure));
+    }
+
+    bool compare_exchange_weak(T& expected, T desired, memory_order success, memory_order failure)
+    {
+        return __atomic_compare_exchange(&m_value, &expected, &desired, true, static_cast<int>(success), static_cast<int>(failure));
+    }
+
+    // Arithmetic operations return the previous value. For pointers, the difference is in elements (not bytes).
+    T fetch_add(difference_type value, memory_order order)
+        requires(is_integral_v<T> || is_pointer_v<T>)
+    {
+        return __atomic_fetch_add(&m_value, scaled(value), static_cast<int>(order));
+    }
+
+    T fetch_sub(difference_type value, memory_order order)
+        requires(is_integral_v<T> || is_pointer_v<T>)
+    {
+        return __atomic_fetch_sub(&m_value, scaled(value), static_cast<int>(order));
+    }
+
+    T fetch_and(T value, memory_order order)
+        requires is_integral_v<T>
+    {
+        return __atomic_fetch_and(&m_value, value, static_cast<int>(order));
+    }
+
+    T fetch_or(T value, memory_order order)
+        requires is_integral_v<T>
+    {
+        return __atomic_fetch_or(&m_value, value, static_cast<int>(order));
+    }
+
+    T fetch_xor(T value, memory_order order)
+        requires is_integral_v<T>
+    {
+        return __atomic_fetch_xor(&m_value, value, static_cast<int>(order));
+    }
+
+    // Sleep while the value is equal to `old`. This may return spuriously, so callers have to check the value again.
+    void wait(T old) const
+        requires(sizeof(T) == 4)
+    {
+        u32 expected;
+        __builtin_memcpy(&expected, &old, sizeof(T));
+        futex_wait(const_cast<u32*>(reinterpret_cast<u32 const*>(&m_value)), expected);
+    }
+
+    // Wake threads sleeping in wait(). This is a system call, so callers usually only notify if there are any.
+    void notify_one()
+        requires(sizeof(T) == 4)
+    {
+        futex_wake(reinterpret_cast<u32*>(&m_value), 1);
+    }
+
+    void notify_all()
+        requires(sizeof(T) == 4)
+    {
+        futex_wake_all(reinterpret_cast<u32*>(&m_value));
+    }
+
+private:
+    static constexpr auto scaled(difference_type value)
+    {
+        if constexpr (is_pointer_v<T>) {
+            return value * static_cast<ptrdiff_t>(sizeof(*static_cast<T>(nullptr)));
+        } else {
+            return value;
+        }
+    }
+
+    alignas(sizeof(T)) T m_value {};
+};
+
+inline void atomic_thread_fence(memory_order order)
+{
+    __atomic_thread_fence(static_cast<int>(order));
+}
+
+// A hint to the processor that the thread is spinning, which saves power and yields to the other hyperthread.
+inline void cpu_relax()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+}
+
+}
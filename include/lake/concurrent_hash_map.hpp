@@ -0,0 +1,165 @@
+/*
+ * SPDX-FileCopyrightText: 2023 Max Wipfli <mail@maxwipfli.ch>
+ * SPDX-LicenseIdentifier: MIT
+ */
+
+#pragma once
+
+#include "allocator.hpp"
+#include "extras.hpp"
+#include "hash_map.hpp"
+#include "mutex.hpp"
+#include "optional.hpp"
+#include "types.hpp"
+#include <assert.h>
+
+namespace lake {
+
+// A hash map for many threads at once, split into independently locked shards.
+//
+// Every shard is a hash_map with its own reader-writer lock, on its own cache line. The shard is selected by the high
+// bits of the key's hash, while the hash_map inside uses the low bits, so the keys of a shard are still spread over its
+// whole table. Threads working on different shards never contend, and readers of the same shard only share its lock.
+//
+// Values can not be accessed outside of the lock, so find() returns a copy, and upsert() modifies the value in place
+// while holding the lock.
+template <typename K, typename V, allocator Alloc = default_allocator>
+class concurrent_hash_map {
+public:
+    static constexpr size_t default_shard_count = 64;
+
+    // The shard count is rounded up to a power of two.
+    explicit concurrent_hash_map(size_t shard_count = default_shard_count, Alloc allocator = {})
+        : m_allocator(move(allocator))
+    {
+        assert(shard_count > 0);
+        m_shard_count = bit_ceil(shard_count);
+        m_shard_shift = 64 - static_cast<u32>(__builtin_ctzll(m_shard_count));
+        m_shards = static_cast<shard*>(m_allocator.allocate(m_shard_count * sizeof(shard), alignof(shard)));
+        for (size_t i = 0; i < m_shard_count; ++i) {
+            new (&m_shards[i]) shard { {}, hash_map<K, V, Alloc>(m_allocator) };
+        }
+    }
+
+    ~concurrent_hash_map()
+    {
+        for (size_t i = 0; i < m_shard_count; ++i) {
+            m_shards[i].~shard();
+        }
+        m_allocator.deallocate(m_shards, m_shard_count * sizeof(shard), alignof(shard));
+    }
+
+    concurrent_hash_map(concurrent_hash_map const&) = delete;
+    concurrent_hash_map& operator=(concurrent_hash_map const&) = delete;
+    concurrent_hash_map(concurrent_hash_map&&) = delete;
+    concurrent_hash_map& operator=(concurrent_hash_map&&) = delete;
+
+    [[nodiscard]] size_t shard_count() const { return m_shard_count; }
+
+    // The number of entries, which may be outdated as soon as it is returned if other threads modify the map.
+    [[nodiscard]] size_t size() const
+    {
+        size_t result = 0;
+        for (size_t i = 0; i < m_shard_count; ++i) {
+            shared_lock_guard guard(m_shards[i].lock);
+            result += m_shards[i].map.size();
+        }
+        return result;
+    }
+    [[nodiscard]] bool empty() const { return size() == 0; }
+
+    // Return a copy of the value for `key`, if it is present.
+    [[nodiscard]] optional<V> find(K const& key) const
+    {
+        auto hash = hash_of(key);
+        auto& shard = shard_for(hash);
+        shared_lock_guard guard(shard.lock);
+        if (auto const* value = shard.map.find(key, hash)) {
+            return optional<V>(*value);
+        }
+        return {};
+    }
+
+    [[nodiscard]] bool contains(K const& key) const
+    {
+        auto hash = hash_of(key);
+        auto& shard = shard_for(hash);
+        shared_lock_guard guard(shard.lock);
+        return shard.map.find(key, hash) != nullptr;
+    }
+
+    // Insert `value` for `key`, unless the key is already present. Returns whether the value was inserted.
+    bool insert(K key, V value)
+    {
+        auto hash = hash_of(key);
+        auto& shard = shard_for(hash);
+        lock_guard guard(shard.lock);
+        return shard.map.insert(move(key), move(value), hash);
+    }
+
+    // Insert `value` for `key`, or replace the existing value. Returns whether the key was newly inserted.
+    bool insert_or_assign(K key, V value)
+    {
+        auto hash = hash_of(key);
+        auto& shard = shard_for(hash);
+        lock_guard guard(shard.lock);
+        return shard.map.insert_or_assign(move(key), move(value), hash);
+    }
+
+    // Call `fn(V&)` on the value for `key`, inserting a default-constructed value first if the key is not present. The
+    // shard is locked during the call, so `fn` can read and modify the value atomically, but must not access the map.
+    // Returns whether the key was newly inserted.
+    template <typename Fn>
+    bool upsert(K key, Fn const& fn)
+    {
+        auto hash = hash_of(key);
+        auto& shard = shard_for(hash);
+        lock_guard guard(shard.lock);
+        bool inserted;
+        fn(shard.map.find_or_insert(move(key), hash, inserted));
+        return inserted;
+    }
+
+    // Remove the entry for `key`. Returns whether it was present.
+    bool remove(K const& key)
+    {
+        auto hash = hash_of(key);
+        auto& shard = shard_for(hash);
+        lock_guard guard(shard.lock);
+        return shard.map.remove(key, hash);
+    }
+
+    // Remove all entries. Shards are cleared one after the other, so concurrent insertions may survive.
+    void clear()
+    {
+        for (size_t i = 0; i < m_shard_count; ++i) {
+            lock_guard guard(m_shards[i].lock);
+            m_shards[i].map.clear();
+        }
+    }
+
+private:
+    struct alignas(64) shard {
+        mutable rw_spinlock lock;
+        hash_map<K, V, Alloc> map;
+    };
+
+    // Every operation hashes the key once, and passes the hash on to the shard's hash_map.
+    static size_t hash_of(K const& key) { return hash_map<K, V, Alloc>::hash_of(key); }
+
+    shard& shard_for(size_t hash) const
+    {
+        // A single shard would need a shift by 64, which is undefined.
+        if (m_shard_count == 1) {
+            return m_shards[0];
+        }
+        return m_shards[hash >> m_shard_shift];
+    }
+
+    shard* m_shards { nullptr };
+    size_t m_shard_count { 0 };
+    u32 m_shard_shift { 0 };
+    [[no_unique_address]] Alloc m_allocator;
+};
+
+}
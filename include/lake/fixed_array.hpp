@@ -5,22 +5,30 @@
 
 #pragma once
 
+#include "allocator.hpp"
 #include "extras.hpp"
+#include "hash.hpp"
 #include "iterator.hpp"
 #include "string_view.hpp"
+#include "type_traits.hpp"
 #include "unique_ptr.hpp"
-#include <stdlib.h>
 
 namespace lake {
 
-template <typename T>
+template <typename T, allocator Alloc = default_allocator>
 class fixed_array {
 public:
     fixed_array() = default;
 
+    explicit fixed_array(Alloc allocator)
+        : m_allocator(move(allocator))
+    {
+    }
+
     // span (copy) constructor/assignment operators
     template <typename U>
-    fixed_array(lake::span<U> span) // NOLINT(google-explicit-constructor)
+    fixed_array(lake::span<U> span, Alloc allocator = {}) // NOLINT(google-explicit-constructor)
+        : m_allocator(move(allocator))
     {
         allocate(span.size());
         for (size_t i = 0; i < span.size(); i++) {
@@ -32,7 +40,7 @@ public:
     }
 
     template <typename U>
-    fixed_array<T>& operator=(lake::span<U> span)
+    fixed_array& operator=(lake::span<U> span)
     {
         // TODO: Reuse storage if the new data has the same number of elements.
         clear();
@@ -47,23 +55,23 @@ public:
 
     // initializer list constructor/assignment operator (via span)
     template <typename U>
-    fixed_array(std::initializer_list<U> initializer_list)
-        : fixed_array(lake::span<U const>(initializer_list))
+    fixed_array(std::initializer_list<U> initializer_list, Alloc allocator = {})
+        : fixed_array(lake::span<U const>(initializer_list), move(allocator))
     {
     }
     template <typename U>
-    fixed_array<T>& operator=(std::initializer_list<U> initializer_list)
+    fixed_array& operator=(std::initializer_list<U> initializer_list)
     {
         *this = lake::span<U const>(initializer_list);
         return *this;
     }
 
     // copy constructor/assignment operator (via span constructor/assignment operator)
-    fixed_array(fixed_array<T> const& other)
-        : fixed_array(other.span())
+    fixed_array(fixed_array const& other)
+        : fixed_array(other.span(), other.m_allocator)
     {
     }
-    fixed_array<T>& operator=(fixed_array<T> const& other)
+    fixed_array& operator=(fixed_array const& other)
     {
         if (this == &other) {
             // self-assignment
@@ -75,15 +83,17 @@ public:
     }
 
     // move constructor/assignment operator
-    fixed_array(fixed_array<T>&& other) noexcept
+    fixed_array(fixed_array&& other) noexcept
         : m_storage(other.m_storage)
+        , m_allocator(move(other.m_allocator))
     {
         other.m_storage = nullptr;
     }
-    fixed_array<T>& operator=(fixed_array<T>&& other) noexcept
+    fixed_array& operator=(fixed_array&& other) noexcept
     {
         clear();
         m_storage = exchange(other.m_storage, nullptr);
+        m_allocator = move(other.m_allocator);
         return *this;
     }
 
@@ -100,7 +110,7 @@ public:
             m_storage->data[i].~T();
         }
 
-        free(m_storage);
+        m_allocator.deallocate(m_storage, storage::allocation_bytes(m_storage->size), alignof(storage));
         m_storage = nullptr;
     }
 
@@ -109,6 +119,7 @@ public:
     [[nodiscard]] T const* data() const { return m_storage ? m_storage->data : nullptr; }
     [[nodiscard]] size_t size() const { return m_storage ? m_storage->size : 0; }
     [[nodiscard]] bool empty() const { return !m_storage; }
+    [[nodiscard]] Alloc const& allocator() const { return m_allocator; }
 
     // spans
     [[nodiscard]] lake::span<T> span() { return { data(), size() }; }
@@ -145,8 +156,8 @@ public:
     [[nodiscard]] const_iterator end() const { return const_iterator(data() + size()); }
 
     // equality operators
-    template <typename U>
-    bool operator==(fixed_array<U> const& other) const
+    template <typename U, typename OtherAlloc>
+    bool operator==(fixed_array<U, OtherAlloc> const& other) const
     {
         if (this == &other) {
             return true;
@@ -170,8 +181,7 @@ private:
             return;
         }
 
-        auto storage_ptr = malloc(storage::allocation_bytes(size));
-        assert(storage_ptr);
+        auto storage_ptr = m_allocator.allocate(storage::allocation_bytes(size), alignof(storage));
         m_storage = static_cast<storage*>(storage_ptr);
         m_storage->size = size;
     }
@@ -191,8 +201,22 @@ private:
 
     // If m_storage == nullptr, then there are 0 elements.
     storage* m_storage { nullptr };
+    [[no_unique_address]] Alloc m_allocator;
 };
 
 static_assert(sizeof(fixed_array<size_t>) == sizeof(void*), "sizeof(fixed_array<T>) == pointer size");
 
+// fixed_array only holds a pointer to its heap storage (and its allocator), so it can be relocated freely.
+template <typename T, typename Alloc>
+struct is_trivially_relocatable<fixed_array<T, Alloc>> : is_trivially_relocatable<Alloc> {
+};
+
+template <typename T, typename Alloc>
+struct hash<fixed_array<T, Alloc>> {
+    constexpr void operator()(hash_state& h, fixed_array<T, Alloc> const& value)
+    {
+        h.hash(value.span());
+    }
+};
+
 }
@@ -0,0 +1,35 @@
+/*
+ * SPDX-FileCopyrightText: 2023 Max Wipfli <mail@maxwipfli.ch>
+ * SPDX-LicenseIdentifier: MIT
+ */
+
+#pragma once
+
+#include "types.hpp"
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace lake {
+
+// Wrappers around the Linux futex system call, which lets threads sleep until a 32-bit word changes. The futexes are
+// process-private.
+
+// Sleep while `*address == expected`. This may return spuriously, so callers have to check their condition again.
+inline void futex_wait(u32* address, u32 expected)
+{
+    syscall(SYS_futex, address, FUTEX_WAIT_PRIVATE, expected, nullptr, nullptr, 0);
+}
+
+// Wake up to `count` threads sleeping on `address`.
+inline void futex_wake(u32* address, u32 count)
+{
+    syscall(SYS_futex, address, FUTEX_WAKE_PRIVATE, count, nullptr, nullptr, 0);
+}
+
+inline void futex_wake_all(u32* address)
+{
+    futex_wake(address, __INT_MAX__);
+}
+
+}
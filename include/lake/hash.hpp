@@ -3,9 +3,17 @@
  * SPDX-LicenseIdentifier: MIT
  */
 
+#pragma once
+
+#include "array.hpp"
+#include "span.hpp"
+#include "string_view.hpp"
+#include "type_traits.hpp"
 #include "types.hpp"
 
-#pragma once
+#ifdef __SSE2__
+#    include <emmintrin.h>
+#endif
 
 namespace lake {
 
@@ -28,8 +36,68 @@ public:
     //       from scratch.
     constexpr void combine_with(hash_t hash)
     {
-        // FIXME: This slowly discards the information of the values first combined into the state.
-        m_state = (m_state << 1) ^ hash;
+        // Both the previous state and the new value go through a full 64x64->128 bit multiplication, so every input bit
+        // affects the whole state. The product is zero if either operand is, so both inputs are also folded in directly:
+        // otherwise, a value equal to secret[1] would erase all earlier input (and a state equal to secret[0] the new
+        // one).
+        m_state ^= mix(m_state ^ secret[0], hash ^ secret[1]) ^ hash;
+    }
+
+    // Hash `size` bytes at once, which is much faster than combining them one by one. Short inputs are read with a few
+    // overlapping loads, medium inputs 16 or 48 bytes per step, and long inputs 64 bytes per step (with SSE2, if
+    // available). The size is part of the hash.
+    // NOTE: This function should only ever be called by lake::hash::operator() to implement hashing for a new type
+    //       from scratch.
+    constexpr void hash_bytes(char const* data, size_t size)
+    {
+        u64 seed = m_state ^ secret[0];
+        u64 a;
+        u64 b;
+        if (size <= 16) {
+            if (size >= 4) {
+                auto offset = (size >> 3) << 2;
+                a = (read32(data) << 32) | read32(data + offset);
+                b = (read32(data + size - 4) << 32) | read32(data + size - 4 - offset);
+            } else if (size > 0) {
+                a = (byte(data, 0) << 16) | (byte(data, size >> 1) << 8) | byte(data, size - 1);
+                b = 0;
+            } else {
+                a = 0;
+                b = 0;
+            }
+        } else if (size <= long_input_size) {
+            auto const* ptr = data;
+            auto remaining = size;
+            if (remaining > 48) {
+                u64 seed1 = seed;
+                u64 seed2 = seed;
+                do {
+                    seed = mix(read64(ptr) ^ secret[1], read64(ptr + 8) ^ seed);
+                    seed1 = mix(read64(ptr + 16) ^ secret[2], read64(ptr + 24) ^ seed1);
+                    seed2 = mix(read64(ptr + 32) ^ secret[3], read64(ptr + 40) ^ seed2);
+                    ptr += 48;
+                    remaining -= 48;
+                } while (remaining > 48);
+                seed ^= seed1 ^ seed2;
+            }
+            while (remaining > 16) {
+                seed = mix(read64(ptr) ^ secret[1], read64(ptr + 8) ^ seed);
+                ptr += 16;
+                remaining -= 16;
+            }
+            // The last 16 bytes of the input, which may overlap with the ones already processed.
+            a = read64(ptr + remaining - 16);
+            b = read64(ptr + remaining - 8);
+        } else {
+            a = hash_long(data, size);
+            b = 0;
+        }
+        combine_with(mix(a ^ secret[1], b ^ seed) ^ size);
+    }
+
+    void hash_bytes(void const* data, size_t size)
+    {
+        hash_bytes(static_cast<char const*>(data), size);
     }
 
     // WARNING: This requires that the iteration order of [begin, end) is deterministic, which is not the case for
@@ -42,9 +110,192 @@ public:
         }
     }
 
-    [[nodiscard]] constexpr hash_t value() const { return m_state; }
+    // The value is finalized with another round of mixing, so that all bits of the result (in particular the low ones
+    // used by hash tables) depend on the last input as well.
+    [[nodiscard]] constexpr hash_t value() const { return mix(m_state ^ secret[2], secret[3]); }
 
 private:
+    // Multiply-fold mixing as used by wyhash and rapidhash: the 128-bit product of the inputs, with its halves XORed.
+    static constexpr u64 mix(u64 a, u64 b)
+    {
+        auto product = static_cast<unsigned __int128>(a) * b;
+        return static_cast<u64>(product) ^ static_cast<u64>(product >> 64);
+    }
+
+    // Little-endian loads, which also work in constant evaluation.
+    static constexpr u64 byte(char const* data, size_t index) { return static_cast<u8>(data[index]); }
+    static constexpr u64 read64(char const* data)
+    {
+        if (__builtin_is_constant_evaluated()) {
+            u64 value = 0;
+            for (size_t i = 0; i < 8; ++i) {
+                value |= byte(data, i) << (8 * i);
+            }
+            return value;
+        }
+        u64 value;
+        __builtin_memcpy(&value, data, sizeof(value));
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+        value = __builtin_bswap64(value);
+#endif
+        return value;
+    }
+    static constexpr u64 read32(char const* data)
+    {
+        if (__builtin_is_constant_evaluated()) {
+            return byte(data, 0) | (byte(data, 1) << 8) | (byte(data, 2) << 16) | (byte(data, 3) << 24);
+        }
+        u32 value;
+        __builtin_memcpy(&value, data, sizeof(value));
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+        value = __builtin_bswap32(value);
+#endif
+        return value;
+    }
+
+    // Long inputs are processed in 64-byte stripes by 8 independent 64-bit accumulators, in the style of XXH3. Each lane
+    // adds the product of the low and high halves of (data ^ key), plus the data of its neighbouring lane. The key
+    // depends on the stripe's position within a block of 16 stripes, and the accumulators are scrambled after every
+    // block.
+    static constexpr size_t long_input_size = 512;
+    static constexpr size_t stripe_size = 64;
+    static constexpr size_t stripes_per_block = 16;
+    static constexpr size_t last_stripe_key_offset = 7;
+    static constexpr u64 scramble_prime = 0x9e3779b1;
+
+    struct scalar_accumulator {
+        constexpr void accumulate(char const* stripe, size_t key_offset)
+        {
+            for (size_t i = 0; i < 8; ++i) {
+                auto data = read64(stripe + 8 * i);
+                auto key = data ^ stripe_secret[key_offset + i];
+                lanes[i ^ 1] += data;
+                lanes[i] += (key & 0xffffffff) * (key >> 32);
+            }
+        }
+
+        constexpr void scramble()
+        {
+            for (size_t i = 0; i < 8; ++i) {
+                lanes[i] = (lanes[i] ^ (lanes[i] >> 47) ^ stripe_secret[16 + i]) * scramble_prime;
+            }
+        }
+
+        u64 lanes[8] { 0x00000000c2b2ae3dull, 0x9e3779b185ebca87ull, 0xc2b2ae3d27d4eb4full, 0x165667b19e3779f9ull,
+            0x85ebca77c2b2ae63ull, 0x0000000085ebca77ull, 0x27d4eb2f165667c5ull, 0x000000009e3779b1ull };
+    };
+
+#ifdef __SSE2__
+    // Computes exactly the same as scalar_accumulator, two lanes per register.
+    struct sse2_accumulator {
+        sse2_accumulator()
+        {
+            scalar_accumulator initial;
+            for (size_t i = 0; i < 4; ++i) {
+                lanes[i] = _mm_loadu_si128(reinterpret_cast<__m128i const*>(&initial.lanes[2 * i]));
+            }
+        }
+
+        void accumulate(char const* stripe, size_t key_offset)
+        {
+            for (size_t i = 0; i < 4; ++i) {
+                auto data = _mm_loadu_si128(reinterpret_cast<__m128i const*>(stripe + 16 * i));
+                auto key = _mm_xor_si128(data, _mm_loadu_si128(reinterpret_cast<__m128i const*>(&stripe_secret[key_offset + 2 * i])));
+                auto product = _mm_mul_epu32(key, _mm_shuffle_epi32(key, _MM_SHUFFLE(0, 3, 0, 1)));
+                auto swapped_data = _mm_shuffle_epi32(data, _MM_SHUFFLE(1, 0, 3, 2));
+                lanes[i] = _mm_add_epi64(lanes[i], _mm_add_epi64(product, swapped_data));
+            }
+        }
+
+        void scramble()
+        {
+            auto prime = _mm_set1_epi32(static_cast<int>(scramble_prime));
+            for (size_t i = 0; i < 4; ++i) {
+                auto key = _mm_loadu_si128(reinterpret_cast<__m128i const*>(&stripe_secret[16 + 2 * i]));
+                auto value = _mm_xor_si128(_mm_xor_si128(lanes[i], _mm_srli_epi64(lanes[i], 47)), key);
+                // 64x32 bit multiplication, from two 32x32->64 bit multiplications.
+                auto low = _mm_mul_epu32(value, prime);
+                auto high = _mm_slli_epi64(_mm_mul_epu32(_mm_srli_epi64(value, 32), prime), 32);
+                lanes[i] = _mm_add_epi64(low, high);
+            }
+        }
+
+        void store(u64* out) const
+        {
+            for (size_t i = 0; i < 4; ++i) {
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(&out[2 * i]), lanes[i]);
+            }
+        }
+
+        __m128i lanes[4];
+    };
+#endif
+
+    template <typename Accumulator>
+    static constexpr void accumulate_long(Accumulator& accumulator, char const* data, size_t size)
+    {
+        constexpr size_t block_size = stripe_size * stripes_per_block;
+        // The last stripe is always processed separately (and may overlap with the previous one), so that the input
+        // does not end with a scramble.
+        auto block_count = (size - 1) / block_size;
+        for (size_t block = 0; block < block_count; ++block) {
+            for (size_t stripe = 0; stripe < stripes_per_block; ++stripe) {
+                accumulator.accumulate(data + block * block_size + stripe * stripe_size, stripe);
+            }
+            accumulator.scramble();
+        }
+        auto stripe_count = ((size - 1) - block_count * block_size) / stripe_size;
+        for (size_t stripe = 0; stripe < stripe_count; ++stripe) {
+            accumulator.accumulate(data + block_count * block_size + stripe * stripe_size, stripe);
+        }
+        accumulator.accumulate(data + size - stripe_size, last_stripe_key_offset);
+    }
+
+#ifdef __SSE2__
+    static void accumulate_long_sse2(char const* data, size_t size, u64* lanes)
+    {
+        sse2_accumulator accumulator;
+        accumulate_long(accumulator, data, size);
+        accumulator.store(lanes);
+    }
+#endif
+
+    static constexpr u64 hash_long(char const* data, size_t size)
+    {
+        u64 lanes[8] {};
+#ifdef __SSE2__
+        if (!__builtin_is_constant_evaluated()) {
+            accumulate_long_sse2(data, size, lanes);
+        } else
+#endif
+        {
+            scalar_accumulator accumulator;
+            accumulate_long(accumulator, data, size);
+            for (size_t i = 0; i < 8; ++i) {
+                lanes[i] = accumulator.lanes[i];
+            }
+        }
+
+        u64 result = size * 0x9e3779b185ebca87ull;
+        for (size_t i = 0; i < 4; ++i) {
+            result += mix(lanes[2 * i] ^ stripe_secret[2 * i], lanes[2 * i + 1] ^ stripe_secret[2 * i + 1]);
+        }
+        return result;
+    }
+
+    // Arbitrary odd constants with a balanced number of set bits (taken from wyhash).
+    static constexpr u64 secret[] = { 0x2d358dccaa6c78a5ull, 0x8bb84b93962eacc9ull, 0x4b33a62ed433d4a3ull, 0x4d5a2da51de1aa47ull };
+
+    // Keys for long inputs (generated with splitmix64).
+    static constexpr u64 stripe_secret[24] = {
+        0x1ac046dda8e86e2aull, 0xbe2c3b00b1d348c8ull, 0x9b1a66a95412ff75ull, 0xc448c2b1f05f7e4cull,
+        0xc111ca6b8f6e73c4ull, 0xb54861920d05b01dull, 0x8d61500f4a7bbe16ull, 0x5e0c25471f89e02eull,
+        0x48105a3d28f0e221ull, 0x2169f8846b637746ull, 0x3d628782e0c0d863ull, 0xa5ddb2216078aa40ull,
+        0xc8119d17f0571101ull, 0x98e2e2eb8f33280full, 0x8cd1e28860679cc4ull, 0x9dca6189c923aef3ull,
+        0x9d8d3071ba4f04c4ull, 0x5d395ada34220c26ull, 0xe6de42a441a1e28eull, 0x308fbf68cc864f59ull,
+        0x216a3c81332862f9ull, 0xbaceca0a77f3132eull, 0xdf2a2215339ca69cull, 0x3e4c11a103a5d859ull
+    };
+
     hash_t m_state { 0 };
 };
 
@@ -55,6 +306,15 @@ struct hash {
     constexpr void operator()(hash_state& h, T const& value);
 };
 
+// Types whose values are equal if and only if their object representations are equal. Contiguous sequences of such
+// types are hashed as raw bytes, using hash_state::hash_bytes().
+template <typename T>
+struct is_trivially_hashable : false_type {
+};
+
+template <typename T>
+inline constexpr bool is_trivially_hashable_v = is_trivially_hashable<T>::value;
+
 #define LAKE_HASH_DEFINE(type, body)                                \
     template <>                                                     \
     struct hash<type> {                                             \
@@ -62,8 +322,11 @@ struct hash {
         {                                                           \
             body;                                                   \
         }                                                           \
+    };                                                              \
+    template <>                                                     \
+    struct is_trivially_hashable<type> : true_type {                \
     }
-LAKE_HASH_DEFINE(u64, h.combine_with((value << 3) ^ value));
+LAKE_HASH_DEFINE(u64, h.combine_with(value));
 LAKE_HASH_DEFINE(i64, h.hash(static_cast<u64>(value)));
 LAKE_HASH_DEFINE(u32, h.hash(static_cast<u64>(value)));
 LAKE_HASH_DEFINE(i32, h.hash(static_cast<u64>(value)));
@@ -74,4 +337,38 @@ LAKE_HASH_DEFINE(i8, h.hash(static_cast<u64>(value)));
 LAKE_HASH_DEFINE(char, h.hash(static_cast<u64>(value)));
 #undef LAKE_HASH_DEFINE
 
+// Contiguous sequences of trivially hashable elements are hashed in bulk, others element by element.
+template <typename T>
+struct hash<span<T>> {
+    constexpr void operator()(hash_state& h, span<T> const& value)
+    {
+        using element_type = remove_const_t<T>;
+        if constexpr (is_same_v<element_type, char>) {
+            // This does not need a cast, so that strings can be hashed in constant evaluation.
+            h.hash_bytes(value.data(), value.size());
+        } else if constexpr (is_trivially_hashable_v<element_type>) {
+            h.hash_bytes(static_cast<void const*>(value.data()), value.size() * sizeof(T));
+        } else {
+            h.hash(static_cast<u64>(value.size()));
+            h.hash_range(value.begin(), value.end());
+        }
+    }
+};
+
+template <>
+struct hash<string_view> {
+    constexpr void operator()(hash_state& h, string_view const& value)
+    {
+        h.hash(static_cast<span<char const> const&>(value));
+    }
+};
+
+template <typename T, size_t Size>
+struct hash<array<T, Size>> {
+    constexpr void operator()(hash_state& h, array<T, Size> const& value)
+    {
+        h.hash(value.span());
+    }
+};
+
 }
@@ -0,0 +1,474 @@
+/*
+ * SPDX-FileCopyrightText: 2023 Max Wipfli <mail@maxwipfli.ch>
+ * SPDX-LicenseIdentifier: MIT
+ */
+
+#pragma once
+
+#include "allocator.hpp"
+#include "extras.hpp"
+#include "hash.hpp"
+#include "type_traits.hpp"
+#include "types.hpp"
+#include <assert.h>
+
+#ifdef __SSE2__
+#    include <emmintrin.h>
+#endif
+
+namespace lake {
+
+template <typename K, typename V, allocator Alloc>
+class concurrent_hash_map;
+
+// An open-addressing hash map, modelled after the "Swiss table" design.
+//
+// Every slot has a control byte, which marks it as empty, deleted or full. For full slots, the control byte holds 7 bits
+// of the key's hash. Control bytes are kept in a separate array and probed in groups of 16, which lets lookups reject most
+// non-matching slots without touching the entries themselves. The entries (key and value) are stored in one flat array
+// in the same allocation.
+template <typename K, typename V, allocator Alloc = default_allocator>
+class hash_map {
+public:
+    struct entry {
+        K key;
+        V value;
+    };
+
+private:
+    static constexpr size_t group_width = 16;
+
+    // Control bytes. Full slots have the high bit clear, empty and deleted ones have it set.
+    static constexpr i8 control_empty = -128;
+    static constexpr i8 control_deleted = -2;
+
+    // A group of control bytes, which can be matched against a pattern all at once. Matches are returned as a bitmask,
+    // where bit i corresponds to the i-th slot in the group.
+    struct group {
+#ifdef __SSE2__
+        explicit group(i8 const* control)
+            : m_control(_mm_load_si128(reinterpret_cast<__m128i const*>(control)))
+        {
+        }
+
+        [[nodiscard]] u32 match(i8 pattern) const
+        {
+            return _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(pattern), m_control));
+        }
+
+        [[nodiscard]] u32 match_empty() const { return match(control_empty); }
+
+        // Empty and deleted are the only control bytes below -1.
+        [[nodiscard]] u32 match_empty_or_deleted() const
+        {
+            return _mm_movemask_epi8(_mm_cmpgt_epi8(_mm_set1_epi8(-1), m_control));
+        }
+
+        __m128i m_control;
+#else
+        explicit group(i8 const* control)
+            : m_control(control)
+        {
+        }
+
+        [[nodiscard]] u32 match(i8 pattern) const
+        {
+            u32 mask = 0;
+            for (size_t i = 0; i < group_width; ++i) {
+                mask |= static_cast<u32>(m_control[i] == pattern) << i;
+            }
+            return mask;
+        }
+
+        [[nodiscard]] u32 match_empty() const { return match(control_empty); }
+
+        [[nodiscard]] u32 match_empty_or_deleted() const
+        {
+            u32 mask = 0;
+            for (size_t i = 0; i < group_width; ++i) {
+                mask |= static_cast<u32>(m_control[i] < -1) << i;
+            }
+            return mask;
+        }
+
+        i8 const* m_control;
+#endif
+    };
+
+public:
+    hash_map() = default;
+
+    explicit hash_map(Alloc allocator)
+        : m_allocator(move(allocator))
+    {
+    }
+
+    hash_map(hash_map const&) = delete;
+    hash_map& operator=(hash_map const&) = delete;
+
+    hash_map(hash_map&& other) noexcept
+        : m_control(exchange(other.m_control, nullptr))
+        , m_entries(exchange(other.m_entries, nullptr))
+        , m_capacity(exchange(other.m_capacity, 0))
+        , m_size(exchange(other.m_size, 0))
+        , m_growth_left(exchange(other.m_growth_left, 0))
+        , m_allocator(move(other.m_allocator))
+    {
+    }
+
+    hash_map& operator=(hash_map&& other) noexcept
+    {
+        if (this == &other) {
+            return *this;
+        }
+        clear();
+        m_control = exchange(other.m_control, nullptr);
+        m_entries = exchange(other.m_entries, nullptr);
+        m_capacity = exchange(other.m_capacity, 0);
+        m_size = exchange(other.m_size, 0);
+        m_growth_left = exchange(other.m_growth_left, 0);
+        m_allocator = move(other.m_allocator);
+        return *this;
+    }
+
+    ~hash_map() { clear(); }
+
+    [[nodiscard]] size_t size() const { return m_size; }
+    [[nodiscard]] size_t capacity() const { return m_capacity; }
+    [[nodiscard]] bool empty() const { return m_size == 0; }
+    [[nodiscard]] Alloc const& allocator() const { return m_allocator; }
+
+    // Returns a pointer to the value stored for `key`, or nullptr if there is none.
+    [[nodiscard]] V* find(K const& key) { return find(key, hash_of(key)); }
+    [[nodiscard]] V const* find(K const& key) const { return find(key, hash_of(key)); }
+
+    [[nodiscard]] bool contains(K const& key) const { return find(key) != nullptr; }
+
+    // Insert `value` for `key`, unless the key is already present. Returns whether the value was inserted.
+    bool insert(K key, V value)
+    {
+        auto hash = hash_of(key);
+        return insert(move(key), move(value), hash);
+    }
+
+    // Insert `value` for `key`, or overwrite the existing value. Returns whether the value was inserted.
+    bool insert_or_assign(K key, V value)
+    {
+        auto hash = hash_of(key);
+        return insert_or_assign(move(key), move(value), hash);
+    }
+
+    // Remove the entry for `key`. Returns whether there was one.
+    bool remove(K const& key) { return remove(key, hash_of(key)); }
+
+    // Make room for at least `count` entries without rehashing.
+    void reserve(size_t count)
+    {
+        if (count <= m_size + m_growth_left) {
+            return;
+        }
+        rehash(capacity_for(count));
+    }
+
+    // Remove all entries and release the storage.
+    void clear()
+    {
+        if (!m_control) {
+            return;
+        }
+        destroy_entries();
+        m_allocator.deallocate(m_control, allocation_size(m_capacity), allocation_alignment);
+        m_control = nullptr;
+        m_entries = nullptr;
+        m_capacity = 0;
+        m_size = 0;
+        m_growth_left = 0;
+    }
+
+    template <bool Const>
+    class basic_iterator {
+    public:
+        using map_type = conditional_t<Const, hash_map const, hash_map>;
+        using entry_type = conditional_t<Const, entry const, entry>;
+
+        basic_iterator(map_type* map, size_t index)
+            : m_map(map)
+            , m_index(index)
+        {
+            skip_to_full();
+        }
+
+        bool operator==(basic_iterator const& other) const { return m_index == other.m_index; }
+        bool operator!=(basic_iterator const& other) const { return !(*this == other); }
+
+        basic_iterator& operator++()
+        {
+            ++m_index;
+            skip_to_full();
+            return *this;
+        }
+
+        entry_type& operator*() const { return m_map->m_entries[m_index]; }
+        entry_type* operator->() const { return &m_map->m_entries[m_index]; }
+
+    private:
+        void skip_to_full()
+        {
+            while (m_index < m_map->m_capacity && m_map->m_control[m_index] < 0) {
+                ++m_index;
+            }
+        }
+
+        map_type* m_map;
+        size_t m_index;
+    };
+
+    using iterator = basic_iterator<false>;
+    using const_iterator = basic_iterator<true>;
+    [[nodiscard]] iterator begin() { return iterator(this, 0); }
+    [[nodiscard]] const_iterator begin() const { return const_iterator(this, 0); }
+    [[nodiscard]] iterator end() { return iterator(this, m_capacity); }
+    [[nodiscard]] const_iterator end() const { return const_iterator(this, m_capacity); }
+
+private:
+    static constexpr size_t not_found = static_cast<size_t>(-1);
+
+    template <typename, typename, lake::allocator>
+    friend class concurrent_hash_map;
+
+    // The operations above, for a `hash` computed by hash_of(key). concurrent_hash_map computes it once and uses it for
+    // selecting the shard as well.
+    [[nodiscard]] V* find(K const& key, size_t hash)
+    {
+        auto index = find_index(key, hash);
+        return index != not_found ? &m_entries[index].value : nullptr;
+    }
+    [[nodiscard]] V const* find(K const& key, size_t hash) const
+    {
+        auto index = find_index(key, hash);
+        return index != not_found ? &m_entries[index].value : nullptr;
+    }
+
+    bool insert(K key, V value, size_t hash)
+    {
+        if (find_index(key, hash) != not_found) {
+            return false;
+        }
+        auto index = prepare_insert(hash);
+        new (&m_entries[index]) entry { move(key), move(value) };
+        return true;
+    }
+
+    bool insert_or_assign(K key, V value, size_t hash)
+    {
+        if (auto index = find_index(key, hash); index != not_found) {
+            m_entries[index].value = move(value);
+            return false;
+        }
+        auto index = prepare_insert(hash);
+        new (&m_entries[index]) entry { move(key), move(value) };
+        return true;
+    }
+
+    // Returns the value for `key`, which is inserted default-constructed if it is not present yet. `inserted` tells
+    // which one was the case.
+    V& find_or_insert(K key, size_t hash, bool& inserted)
+    {
+        if (auto index = find_index(key, hash); index != not_found) {
+            inserted = false;
+            return m_entries[index].value;
+        }
+        auto index = prepare_insert(hash);
+        new (&m_entries[index]) entry { move(key), V {} };
+        inserted = true;
+        return m_entries[index].value;
+    }
+
+    bool remove(K const& key, size_t hash)
+    {
+        auto index = find_index(key, hash);
+        if (index == not_found) {
+            return false;
+        }
+        m_entries[index].~entry();
+        --m_size;
+
+        // If the slot's group still has an empty slot, it has never been full. Therefore, no lookup has ever probed
+        // past it, and the slot can be marked empty instead of leaving a tombstone.
+        auto group_start = index & ~(group_width - 1);
+        if (group(&m_control[group_start]).match_empty() != 0) {
+            m_control[index] = control_empty;
+            ++m_growth_left;
+        } else {
+            m_control[index] = control_deleted;
+        }
+        return true;
+    }
+
+    static constexpr size_t entries_offset(size_t capacity)
+    {
+        return (capacity + alignof(entry) - 1) & ~(alignof(entry) - 1);
+    }
+    static constexpr size_t allocation_size(size_t capacity)
+    {
+        return entries_offset(capacity) + capacity * sizeof(entry);
+    }
+    static constexpr size_t allocation_alignment = alignof(entry) > group_width ? alignof(entry) : group_width;
+
+    // The maximum load factor is 7/8.
+    static constexpr size_t max_size_for(size_t capacity) { return capacity - capacity / 8; }
+    static constexpr size_t capacity_for(size_t count)
+    {
+        size_t capacity = group_width;
+        while (max_size_for(capacity) < count) {
+            capacity *= 2;
+        }
+        return capacity;
+    }
+
+    static size_t hash_of(K const& key)
+    {
+        hash_state state;
+        state.hash(key);
+        return state.value();
+    }
+
+    // The low 7 bits of the hash are stored in the control byte, the remaining bits select the first group to probe.
+    static i8 h2(size_t hash) { return static_cast<i8>(hash & 0x7f); }
+    static size_t h1(size_t hash) { return hash >> 7; }
+
+    // Groups are probed quadratically (by triangular numbers), which visits every group once if the number of groups is
+    // a power of two.
+    class probe_sequence {
+    public:
+        probe_sequence(size_t hash, size_t group_count)
+            : m_mask(group_count - 1)
+            , m_group(h1(hash) & m_mask)
+        {
+        }
+
+        [[nodiscard]] size_t offset() const { return m_group * group_width; }
+
+        void next()
+        {
+            ++m_stride;
+            m_group = (m_group + m_stride) & m_mask;
+        }
+
+    private:
+        size_t m_mask;
+        size_t m_group;
+        size_t m_stride { 0 };
+    };
+
+    size_t find_index(K const& key, size_t hash) const
+    {
+        if (m_size == 0) {
+            return not_found;
+        }
+        probe_sequence sequence(hash, m_capacity / group_width);
+        while (true) {
+            group g(&m_control[sequence.offset()]);
+            for (auto mask = g.match(h2(hash)); mask != 0; mask &= mask - 1) {
+                auto index = sequence.offset() + __builtin_ctz(mask);
+                if (m_entries[index].key == key) {
+                    return index;
+                }
+            }
+            if (g.match_empty() != 0) {
+                return not_found;
+            }
+            sequence.next();
+        }
+    }
+
+    // Find the first empty or deleted slot in the probe sequence for `hash`.
+    size_t find_free_slot(size_t hash) const
+    {
+        probe_sequence sequence(hash, m_capacity / group_width);
+        while (true) {
+            auto mask = group(&m_control[sequence.offset()]).match_empty_or_deleted();
+            if (mask != 0) {
+                return sequence.offset() + __builtin_ctz(mask);
+            }
+            sequence.next();
+        }
+    }
+
+    // Claim a slot for a new entry with `hash`, growing the table if necessary. The entry has to be constructed by the
+    // caller.
+    size_t prepare_insert(size_t hash)
+    {
+        if (!m_control) {
+            rehash(group_width);
+        }
+        auto index = find_free_slot(hash);
+        if (m_growth_left == 0 && m_control[index] == control_empty) {
+            // If tombstones take up a large part of the table (the table is less than 25/32 full), rehashing at the same
+            // capacity is enough to make room.
+            rehash(m_size * 32 <= m_capacity * 25 ? m_capacity : m_capacity * 2);
+            index = find_free_slot(hash);
+        }
+        if (m_control[index] == control_empty) {
+            --m_growth_left;
+        }
+        m_control[index] = h2(hash);
+        ++m_size;
+        return index;
+    }
+
+    void rehash(size_t new_capacity)
+    {
+        assert(new_capacity >= group_width && (new_capacity & (new_capacity - 1)) == 0);
+        assert(max_size_for(new_capacity) >= m_size);
+
+        auto* old_control = m_control;
+        auto* old_entries = m_entries;
+        auto old_capacity = m_capacity;
+
+        auto* allocation = static_cast<u8*>(m_allocator.allocate(allocation_size(new_capacity), allocation_alignment));
+        m_control = reinterpret_cast<i8*>(allocation);
+        m_entries = reinterpret_cast<entry*>(allocation + entries_offset(new_capacity));
+        m_capacity = new_capacity;
+        m_growth_left = max_size_for(new_capacity) - m_size;
+        __builtin_memset(m_control, control_empty, new_capacity);
+
+        if (!old_control) {
+            return;
+        }
+        for (size_t i = 0; i < old_capacity; ++i) {
+            if (old_control[i] < 0) {
+                continue;
+            }
+            auto hash = hash_of(old_entries[i].key);
+            auto index = find_free_slot(hash);
+            m_control[index] = h2(hash);
+            if constexpr (is_trivially_relocatable_v<K> && is_trivially_relocatable_v<V>) {
+                __builtin_memcpy(static_cast<void*>(&m_entries[index]), &old_entries[i], sizeof(entry));
+            } else {
+                new (&m_entries[index]) entry(move(old_entries[i]));
+                old_entries[i].~entry();
+            }
+        }
+        m_allocator.deallocate(old_control, allocation_size(old_capacity), allocation_alignment);
+    }
+
+    void destroy_entries()
+    {
+        for (size_t i = 0; i < m_capacity; ++i) {
+            if (m_control[i] >= 0) {
+                m_entries[i].~entry();
+            }
+        }
+    }
+
+    i8* m_control { nullptr };
+    entry* m_entries { nullptr };
+    size_t m_capacity { 0 };
+    size_t m_size { 0 };
+    // The number of empty slots which can still be filled before the maximum load factor is reached.
+    size_t m_growth_left { 0 };
+    [[no_unique_address]] Alloc m_allocator;
+};
+
+}
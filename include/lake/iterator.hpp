@@ -5,16 +5,51 @@
 
 #pragma once
 
+#include "type_traits.hpp"
+#include "types.hpp"
+
+// The iterator category tags are only needed to interoperate with the standard library, so they are only used if it is
+// available.
+#if __has_include(<iterator>)
+#    include <iterator>
+#    define LAKE_HAS_STD_ITERATOR 1
+#endif
+
 namespace lake {
 
+// A random-access iterator over contiguous storage, which is a thin wrapper around a pointer. With the standard library
+// available, it models std::contiguous_iterator, so it can be used with standard algorithms and ranges.
 template <typename T>
 class contiguous_iterator {
 public:
+    using value_type = remove_const_t<T>;
+    using element_type = T;
+    using difference_type = ptrdiff_t;
+    using pointer = T*;
+    using reference = T&;
+#ifdef LAKE_HAS_STD_ITERATOR
+    using iterator_category = std::random_access_iterator_tag;
+    using iterator_concept = std::contiguous_iterator_tag;
+#endif
+
+    constexpr contiguous_iterator() = default;
+
     explicit constexpr contiguous_iterator(T* ptr)
         : m_ptr(ptr)
     {
     }
 
+    // Conversion from an iterator over non-const elements to one over const elements.
+    template <typename U>
+    constexpr contiguous_iterator(contiguous_iterator<U> const& other) // NOLINT(google-explicit-constructor)
+        requires(is_same_v<U const, T> && !is_same_v<U, T>)
+        : m_ptr(other.ptr())
+    {
+    }
+
+    [[nodiscard]] constexpr T* ptr() const { return m_ptr; }
+
+    // comparison
     constexpr bool operator==(contiguous_iterator<T> const& other) const
     {
         return m_ptr == other.m_ptr;
@@ -25,12 +60,58 @@ public:
         return !(*this == other);
     }
 
+    constexpr bool operator<(contiguous_iterator<T> const& other) const { return m_ptr < other.m_ptr; }
+    constexpr bool operator>(contiguous_iterator<T> const& other) const { return m_ptr > other.m_ptr; }
+    constexpr bool operator<=(contiguous_iterator<T> const& other) const { return m_ptr <= other.m_ptr; }
+    constexpr bool operator>=(contiguous_iterator<T> const& other) const { return m_ptr >= other.m_ptr; }
+
+    // increment/decrement
     constexpr contiguous_iterator<T>& operator++()
     {
         m_ptr++;
         return *this;
     }
 
+    constexpr contiguous_iterator<T> operator++(int)
+    {
+        auto result = *this;
+        m_ptr++;
+        return result;
+    }
+
+    constexpr contiguous_iterator<T>& operator--()
+    {
+        m_ptr--;
+        return *this;
+    }
+
+    constexpr contiguous_iterator<T> operator--(int)
+    {
+        auto result = *this;
+        m_ptr--;
+        return result;
+    }
+
+    // arithmetic
+    constexpr contiguous_iterator<T>& operator+=(difference_type offset)
+    {
+        m_ptr += offset;
+        return *this;
+    }
+
+    constexpr contiguous_iterator<T>& operator-=(difference_type offset)
+    {
+        m_ptr -= offset;
+        return *this;
+    }
+
+    constexpr contiguous_iterator<T> operator+(difference_type offset) const { return contiguous_iterator(m_ptr + offset); }
+    constexpr contiguous_iterator<T> operator-(difference_type offset) const { return contiguous_iterator(m_ptr - offset); }
+    friend constexpr contiguous_iterator<T> operator+(difference_type offset, contiguous_iterator<T> const& it) { return it + offset; }
+
+    constexpr difference_type operator-(contiguous_iterator<T> const& other) const { return m_ptr - other.m_ptr; }
+
+    // element access
     constexpr T& operator*() const
     {
         return *m_ptr;
@@ -41,8 +122,13 @@ public:
         return m_ptr;
     }
 
+    constexpr T& operator[](difference_type index) const
+    {
+        return m_ptr[index];
+    }
+
 private:
-    T* m_ptr;
+    T* m_ptr { nullptr };
 };
 
 }
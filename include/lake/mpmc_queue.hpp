@@ -0,0 +1,209 @@
+/*
+ * SPDX-FileCopyrightText: 2023 Max Wipfli <mail@maxwipfli.ch>
+ * SPDX-LicenseIdentifier: MIT
+ */
+
+#pragma once
+
+#include "allocator.hpp"
+#include "atomic.hpp"
+#include "extras.hpp"
+#include "optional.hpp"
+#include "types.hpp"
+#include <assert.h>
+
+namespace lake {
+
+// A bounded queue for any number of producer and consumer threads, after Dmitry Vyukov's design.
+//
+// Every slot of the ring buffer has a sequence number, which tells the threads whose turn it is: A producer may fill
+// slot `position % capacity` when its sequence number equals `position`, and a consumer may empty it when it equals
+// `position + 1`. After emptying it, the consumer sets it to `position + capacity`, for the producer of the next round.
+// Threads claim positions by advancing the enqueue or dequeue counter with a compare-and-swap, and otherwise only
+// synchronize through the slot they have claimed. Producers and consumers thus don't contend with each other (except on
+// the slots themselves), and no thread ever waits for another one in try_push() or try_pop().
+//
+// The blocking push() and pop() sleep on a futex while the queue is full or empty. Successful operations only make a
+// system call to wake a thread if there are sleeping ones.
+template <typename T, allocator Alloc = default_allocator>
+class mpmc_queue {
+public:
+    // The capacity is rounded up to a power of two.
+    explicit mpmc_queue(size_t capacity, Alloc allocator = {})
+        : m_allocator(move(allocator))
+    {
+        assert(capacity > 0);
+        m_capacity = bit_ceil(capacity);
+        m_slots = static_cast<slot*>(m_allocator.allocate(m_capacity * sizeof(slot), alignof(slot)));
+        for (size_t i = 0; i < m_capacity; ++i) {
+            new (&m_slots[i]) slot;
+            m_slots[i].sequence.store(i, memory_order::relaxed);
+        }
+    }
+
+    ~mpmc_queue()
+    {
+        while (try_pop().has_value()) {
+        }
+        for (size_t i = 0; i < m_capacity; ++i) {
+            m_slots[i].~slot();
+        }
+        m_allocator.deallocate(m_slots, m_capacity * sizeof(slot), alignof(slot));
+    }
+
+    mpmc_queue(mpmc_queue const&) = delete;
+    mpmc_queue& operator=(mpmc_queue const&) = delete;
+    mpmc_queue(mpmc_queue&&) = delete;
+    mpmc_queue& operator=(mpmc_queue&&) = delete;
+
+    [[nodiscard]] size_t capacity() const { return m_capacity; }
+
+    // The approximate number of elements, which may be outdated as soon as it is returned.
+    [[nodiscard]] size_t size() const
+    {
+        auto dequeue = m_dequeue_position.load(memory_order::relaxed);
+        auto enqueue = m_enqueue_position.load(memory_order::relaxed);
+        return enqueue > dequeue ? enqueue - dequeue : 0;
+    }
+    [[nodiscard]] bool empty() const { return size() == 0; }
+
+    // Construct an element at the end of the queue, or return false if it is full.
+    template <typename... Args>
+    [[nodiscard]] bool try_emplace(Args&&... args)
+    {
+        auto position = m_enqueue_position.load(memory_order::relaxed);
+        while (true) {
+            auto& slot = slot_at(position);
+            auto sequence = slot.sequence.load(memory_order::acquire);
+            auto difference = static_cast<i64>(sequence - position);
+            if (difference == 0) {
+                if (m_enqueue_position.compare_exchange_weak(position, position + 1, memory_order::relaxed, memory_order::relaxed)) {
+                    new (slot.value()) T(forward<Args>(args)...);
+                    slot.sequence.store(position + 1, memory_order::release);
+                    m_not_empty.notify();
+                    return true;
+                }
+            } else if (difference < 0) {
+                // The slot still holds the element from the previous round.
+                return false;
+            } else {
+                // Another producer has claimed this position.
+                position = m_enqueue_position.load(memory_order::relaxed);
+            }
+        }
+    }
+
+    [[nodiscard]] bool try_push(T const& value) { return try_emplace(value); }
+    [[nodiscard]] bool try_push(T&& value) { return try_emplace(move(value)); }
+
+    // Remove the element at the front of the queue, if there is one.
+    [[nodiscard]] optional<T> try_pop()
+    {
+        auto position = m_dequeue_position.load(memory_order::relaxed);
+        while (true) {
+            auto& slot = slot_at(position);
+            auto sequence = slot.sequence.load(memory_order::acquire);
+            auto difference = static_cast<i64>(sequence - (position + 1));
+            if (difference == 0) {
+                if (m_dequeue_position.compare_exchange_weak(position, position + 1, memory_order::relaxed, memory_order::relaxed)) {
+                    optional<T> result(move(*slot.value()));
+                    slot.value()->~T();
+                    slot.sequence.store(position + m_capacity, memory_order::release);
+                    m_not_full.notify();
+                    return result;
+                }
+            } else if (difference < 0) {
+                // The slot has not been filled in this round yet.
+                return {};
+            } else {
+                // Another consumer has claimed this position.
+                position = m_dequeue_position.load(memory_order::relaxed);
+            }
+        }
+    }
+
+    // Construct an element at the end of the queue, waiting while it is full.
+    template <typename... Args>
+    void emplace(Args&&... args)
+    {
+        m_not_full.wait_until([&] { return try_emplace(forward<Args>(args)...); });
+    }
+
+    void push(T const& value) { emplace(value); }
+    void push(T&& value) { emplace(move(value)); }
+
+    // Remove the element at the front of the queue, waiting while it is empty.
+    [[nodiscard]] T pop()
+    {
+        optional<T> result;
+        m_not_empty.wait_until([&] {
+            result = try_pop();
+            return result.has_value();
+        });
+        return result.release_value();
+    }
+
+private:
+    struct slot {
+        T* value() { return reinterpret_cast<T*>(&bytes); }
+
+        atomic<u64> sequence;
+        alignas(T) u8 bytes[sizeof(T)];
+    };
+
+    // Threads waiting for the queue to become non-empty (or non-full). The epoch changes whenever one of them may be able
+    // to continue, which wakes them from the futex.
+    struct alignas(64) wait_point {
+        atomic<u32> epoch { 0 };
+        atomic<u32> waiters { 0 };
+
+        template <typename Fn>
+        void wait_until(Fn const& try_operation)
+        {
+            for (size_t spins = 0; spins < max_spins; ++spins) {
+                if (try_operation()) {
+                    return;
+                }
+                cpu_relax();
+            }
+            while (true) {
+                // Register as a waiter before trying again: An operation completing after that sees the waiter, and
+                // bumps the epoch, so the futex wait returns immediately.
+                auto current_epoch = epoch.load(memory_order::seq_cst);
+                waiters.fetch_add(1, memory_order::seq_cst);
+                auto done = try_operation();
+                if (!done) {
+                    epoch.wait(current_epoch);
+                }
+                waiters.fetch_sub(1, memory_order::seq_cst);
+                if (done) {
+                    return;
+                }
+            }
+        }
+
+        void notify()
+        {
+            atomic_thread_fence(memory_order::seq_cst);
+            if (waiters.load(memory_order::relaxed) > 0) {
+                epoch.fetch_add(1, memory_order::seq_cst);
+                epoch.notify_one();
+            }
+        }
+    };
+
+    static constexpr size_t max_spins = 64;
+
+    slot& slot_at(u64 position) { return m_slots[position & (m_capacity - 1)]; }
+
+    // The counters are on their own cache lines, as they are written by different threads (producers and consumers).
+    alignas(64) atomic<u64> m_enqueue_position { 0 };
+    alignas(64) atomic<u64> m_dequeue_position { 0 };
+    wait_point m_not_empty;
+    wait_point m_not_full;
+    alignas(64) slot* m_slots { nullptr };
+    size_t m_capacity { 0 };
+    [[no_unique_address]] Alloc m_allocator;
+};
+
+}
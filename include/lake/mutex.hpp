@@ -0,0 +1,361 @@
+/*
+ * SPDX-FileCopyrightText: 2023 Max Wipfli <mail@maxwipfli.ch>
+ * SPDX-LicenseIdentifier: MIT
+ */
+
+#pragma once
+
+#include "atomic.hpp"
+#include "types.hpp"
+#include <sched.h>
+
+namespace lake {
+
+// Holds a lock for the lifetime of the guard.
+template <typename Lock>
+class lock_guard {
+public:
+    explicit lock_guard(Lock& lock)
+        : m_lock(lock)
+    {
+        m_lock.lock();
+    }
+
+    ~lock_guard() { m_lock.unlock(); }
+
+    lock_guard(lock_guard const&) = delete;
+    lock_guard& operator=(lock_guard const&) = delete;
+
+private:
+    Lock& m_lock;
+};
+
+// A lock which never sleeps, for very short critical sections. Waiting threads only read the lock (so its cache line
+// is shared until it is released), and back off exponentially to reduce contention. After spinning for a while, they
+// yield the processor, which matters if there are more threads than processors.
+//
+// NOTE: A spinlock in static storage is zero-initialized, and thus unlocked, before any code runs.
+class spinlock {
+public:
+    constexpr spinlock() = default;
+
+    spinlock(spinlock const&) = delete;
+    spinlock& operator=(spinlock const&) = delete;
+
+    void lock()
+    {
+        u32 backoff = 1;
+        while (m_locked.exchange(true, memory_order::acquire)) {
+            while (m_locked.load(memory_order::relaxed)) {
+                if (backoff <= max_backoff) {
+                    for (u32 i = 0; i < backoff; ++i) {
+                        cpu_relax();
+                    }
+                    backoff *= 2;
+                } else {
+                    sched_yield();
+                }
+            }
+        }
+    }
+
+    [[nodiscard]] bool try_lock()
+    {
+        return !m_locked.load(memory_order::relaxed) && !m_locked.exchange(true, memory_order::acquire);
+    }
+
+    void unlock() { m_locked.store(false, memory_order::release); }
+
+private:
+    static constexpr u32 max_backoff = 1024;
+
+    atomic<bool> m_locked { false };
+};
+
+// Holds a reader-writer lock in shared mode for the lifetime of the guard.
+template <typename Lock>
+class shared_lock_guard {
+public:
+    explicit shared_lock_guard(Lock& lock)
+        : m_lock(lock)
+    {
+        m_lock.lock_shared();
+    }
+
+    ~shared_lock_guard() { m_lock.unlock_shared(); }
+
+    shared_lock_guard(shared_lock_guard const&) = delete;
+    shared_lock_guard& operator=(shared_lock_guard const&) = delete;
+
+private:
+    Lock& m_lock;
+};
+
+// A reader-writer spinlock, for very short critical sections which mostly read. Any number of readers may hold the lock
+// in shared mode, or a single writer in exclusive mode. A waiting writer keeps new readers out, so that a steady stream
+// of readers does not starve it.
+class rw_spinlock {
+public:
+    constexpr rw_spinlock() = default;
+
+    rw_spinlock(rw_spinlock const&) = delete;
+    rw_spinlock& operator=(rw_spinlock const&) = delete;
+
+    void lock_shared()
+    {
+        u32 backoff = 1;
+        while (true) {
+            auto state = m_state.load(memory_order::relaxed);
+            if ((state & (writer | writer_waiting)) == 0
+                && m_state.compare_exchange_weak(state, state + reader, memory_order::acquire, memory_order::relaxed)) {
+                return;
+            }
+            wait(backoff);
+        }
+    }
+
+    void unlock_shared() { m_state.fetch_sub(reader, memory_order::release); }
+
+    void lock()
+    {
+        u32 backoff = 1;
+        while (true) {
+            auto state = m_state.load(memory_order::relaxed);
+            if ((state & ~writer_waiting) == 0) {
+                // Taking the lock clears the waiting flag. Other waiting writers set it again while they spin.
+                if (m_state.compare_exchange_weak(state, writer, memory_order::acquire, memory_order::relaxed)) {
+                    return;
+                }
+                continue;
+            }
+            if ((state & writer_waiting) == 0) {
+                m_state.fetch_or(writer_waiting, memory_order::relaxed);
+            }
+            wait(backoff);
+        }
+    }
+
+    void unlock() { m_state.fetch_and(~writer, memory_order::release); }
+
+private:
+    // The low two bits are flags, the remaining bits count the readers.
+    static constexpr u32 writer = 1;
+    static constexpr u32 writer_waiting = 2;
+    static constexpr u32 reader = 4;
+
+    static constexpr u32 max_backoff = 1024;
+
+    static void wait(u32& backoff)
+    {
+        if (backoff <= max_backoff) {
+            for (u32 i = 0; i < backoff; ++i) {
+                cpu_relax();
+            }
+            backoff *= 2;
+        } else {
+            sched_yield();
+        }
+    }
+
+    atomic<u32> m_state { 0 };
+};
+
+// A lock which puts waiting threads to sleep, after Ulrich Drepper's "Futexes Are Tricky". Locking and unlocking an
+// uncontended mutex are a single atomic operation each, and unlock() only makes a system call if there may be sleeping
+// threads.
+class mutex {
+public:
+    constexpr mutex() = default;
+
+    mutex(mutex const&) = delete;
+    mutex& operator=(mutex const&) = delete;
+
+    void lock()
+    {
+        u32 state = unlocked;
+        if (m_state.compare_exchange_strong(state, locked, memory_order::acquire, memory_order::relaxed)) {
+            return;
+        }
+        lock_slow(state);
+    }
+
+    [[nodiscard]] bool try_lock()
+    {
+        u32 state = unlocked;
+        return m_state.compare_exchange_strong(state, locked, memory_order::acquire, memory_order::relaxed);
+    }
+
+    void unlock()
+    {
+        if (m_state.exchange(unlocked, memory_order::release) == contended) {
+            m_state.notify_one();
+        }
+    }
+
+private:
+    friend class condition;
+
+    enum : u32 {
+        unlocked = 0,
+        locked = 1,
+        // Locked, and there may be threads sleeping on the futex.
+        contended = 2,
+    };
+
+    static constexpr size_t max_spins = 100;
+
+    void lock_slow(u32 state)
+    {
+        // Spin for a bit first, as critical sections are often short.
+        for (size_t spins = 0; spins < max_spins && state == locked; ++spins) {
+            cpu_relax();
+            state = m_state.load(memory_order::relaxed);
+            if (state == unlocked && m_state.compare_exchange_strong(state, locked, memory_order::acquire, memory_order::relaxed)) {
+                return;
+            }
+        }
+        lock_contended();
+    }
+
+    // Lock the mutex, marking it as contended. The mutex does not know whether other threads are still sleeping when
+    // this thread gets it, so it has to assume that they are.
+    void lock_contended()
+    {
+        while (m_state.exchange(contended, memory_order::acquire) != unlocked) {
+            m_state.wait(contended);
+        }
+    }
+
+    atomic<u32> m_state { unlocked };
+};
+
+// A condition variable for use with mutex. Waiting threads sleep on a futex for a sequence number, which is incremented
+// by every notification. A notification between unlocking the mutex and going to sleep changes the sequence number, so
+// the thread does not go to sleep and the notification is not lost.
+//
+// As with all condition variables, wait() may return spuriously, so the condition has to be checked again.
+class condition {
+public:
+    constexpr condition() = default;
+
+    condition(condition const&) = delete;
+    condition& operator=(condition const&) = delete;
+
+    // Atomically unlock `mutex` and wait for a notification, then lock `mutex` again.
+    void wait(mutex& mutex)
+    {
+        auto sequence = m_sequence.load(memory_order::relaxed);
+        m_waiters.fetch_add(1, memory_order::relaxed);
+        mutex.unlock();
+        m_sequence.wait(sequence);
+        m_waiters.fetch_sub(1, memory_order::relaxed);
+        // Other threads may have been woken as well, so the mutex has to be considered contended.
+        mutex.lock_contended();
+    }
+
+    // Wait until `predicate()` returns true. `mutex` has to be locked, and is locked when this returns.
+    template <typename Predicate>
+    void wait(mutex& mutex, Predicate const& predicate)
+    {
+        while (!predicate()) {
+            wait(mutex);
+        }
+    }
+
+    // NOTE: To not miss any waiters, the condition has to be changed with the mutex locked. The notification itself may
+    //       happen after unlocking it.
+    void notify_one()
+    {
+        m_sequence.fetch_add(1, memory_order::release);
+        if (m_waiters.load(memory_order::relaxed) > 0) {
+            m_sequence.notify_one();
+        }
+    }
+
+    void notify_all()
+    {
+        m_sequence.fetch_add(1, memory_order::release);
+        if (m_waiters.load(memory_order::relaxed) > 0) {
+            m_sequence.notify_all();
+        }
+    }
+
+private:
+    atomic<u32> m_sequence { 0 };
+    atomic<u32> m_waiters { 0 };
+};
+
+// A sequence lock for small, read-mostly data. Writers are serialized by a spinlock and increment the sequence number
+// before and after modifying the data, so it is odd while a write is in progress. Readers never write to shared memory:
+// They read the data optimistically, and retry if the sequence number was odd or has changed in the meantime.
+//
+// Readers may thus see torn data, which they must only copy (and not follow pointers in, for example) until read()
+// has validated it.
+class seqlock {
+public:
+    constexpr seqlock() = default;
+
+    seqlock(seqlock const&) = delete;
+    seqlock& operator=(seqlock const&) = delete;
+
+    // Call `fn()` until it ran without a concurrent write, and return its result.
+    template <typename Fn>
+    auto read(Fn const& fn) const
+    {
+        while (true) {
+            auto sequence = read_begin();
+            auto result = fn();
+            if (!read_retry(sequence)) {
+                return result;
+            }
+        }
+    }
+
+    // Modify the protected data in `fn()`.
+    template <typename Fn>
+    void write(Fn const& fn)
+    {
+        write_lock();
+        fn();
+        write_unlock();
+    }
+
+    [[nodiscard]] u32 read_begin() const
+    {
+        while (true) {
+            auto sequence = m_sequence.load(memory_order::acquire);
+            if ((sequence & 1) == 0) {
+                return sequence;
+            }
+            cpu_relax();
+        }
+    }
+
+    // Returns true if the data read since read_begin() returned `sequence` may be inconsistent.
+    [[nodiscard]] bool read_retry(u32 sequence) const
+    {
+        // The reads of the data must not be reordered after the check of the sequence number.
+        atomic_thread_fence(memory_order::acquire);
+        return m_sequence.load(memory_order::relaxed) != sequence;
+    }
+
+    void write_lock()
+    {
+        m_writer.lock();
+        m_sequence.store(m_sequence.load(memory_order::relaxed) + 1, memory_order::relaxed);
+        // The writes of the data must not be reordered before the sequence number is made odd.
+        atomic_thread_fence(memory_order::release);
+    }
+
+    void write_unlock()
+    {
+        m_sequence.store(m_sequence.load(memory_order::relaxed) + 1, memory_order::release);
+        m_writer.unlock();
+    }
+
+private:
+    atomic<u32> m_sequence { 0 };
+    spinlock m_writer;
+};
+
+}
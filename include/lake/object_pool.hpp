@@ -0,0 +1,170 @@
+/*
+ * SPDX-FileCopyrightText: 2023 Max Wipfli <mail@maxwipfli.ch>
+ * SPDX-LicenseIdentifier: MIT
+ */
+
+#pragma once
+
+#include "allocator.hpp"
+#include "extras.hpp"
+#include "types.hpp"
+#include "unique_ptr.hpp"
+#include <assert.h>
+
+namespace lake {
+
+template <typename T>
+class pool_allocator;
+
+// A pool of equally-sized slots for objects of type `T`. Slots are carved from large slabs, and freed slots are kept on an
+// intrusive free list (which reuses the memory of the freed object), so both allocating and freeing are O(1). Recently
+// freed slots are reused first, which keeps the working set small.
+//
+// Use create()/destroy(), or a unique_ptr with a pool_allocator (see make_unique()), which returns the object to its
+// pool instead of deleting it.
+//
+// NOTE: All objects have to be destroyed before the pool itself. The pool releases its memory, but does not run the
+//       destructors of objects which are still alive.
+template <typename T>
+class object_pool {
+public:
+    static constexpr size_t default_slab_size = 64 * 1024;
+
+    // `slab_size` is the size of each slab in bytes. Slabs always hold at least one slot.
+    explicit object_pool(size_t slab_size = default_slab_size)
+    {
+        auto slots = (slab_size - slots_offset) / sizeof(slot);
+        m_slots_per_slab = slab_size > slots_offset && slots > 0 ? slots : 1;
+    }
+
+    ~object_pool()
+    {
+        auto* current = m_slabs;
+        while (current) {
+            auto* next = current->next;
+            default_allocator {}.deallocate(current, slab_bytes(), alignof(slab));
+            current = next;
+        }
+    }
+
+    object_pool(object_pool const&) = delete;
+    object_pool& operator=(object_pool const&) = delete;
+    object_pool(object_pool&&) = delete;
+    object_pool& operator=(object_pool&&) = delete;
+
+    // Raw slots, which fit exactly one T.
+    [[nodiscard]] void* allocate()
+    {
+        ++m_size;
+        if (m_free_list) {
+            auto* result = m_free_list;
+            m_free_list = result->next;
+            return result;
+        }
+        if (m_bump == m_bump_end) {
+            allocate_slab();
+        }
+        return m_bump++;
+    }
+
+    void deallocate(void* ptr)
+    {
+        assert(m_size > 0);
+        --m_size;
+        auto* freed = static_cast<slot*>(ptr);
+        freed->next = m_free_list;
+        m_free_list = freed;
+    }
+
+    template <typename... Args>
+    [[nodiscard]] T* create(Args&&... args)
+    {
+        return new (allocate()) T(forward<Args>(args)...);
+    }
+
+    void destroy(T* object)
+    {
+        object->~T();
+        deallocate(object);
+    }
+
+    template <typename... Args>
+    [[nodiscard]] unique_ptr<T, pool_allocator<T>> make_unique(Args&&... args)
+    {
+        return unique_ptr<T, pool_allocator<T>>::create(pool_allocator<T>(*this), forward<Args>(args)...);
+    }
+
+    // The number of objects currently allocated from the pool.
+    [[nodiscard]] size_t size() const { return m_size; }
+    // The number of slots in all slabs, both used and unused.
+    [[nodiscard]] size_t capacity() const { return m_slab_count * m_slots_per_slab; }
+    [[nodiscard]] size_t slots_per_slab() const { return m_slots_per_slab; }
+
+private:
+    // While a slot is free, its memory holds the link to the next free slot.
+    union slot {
+        slot* next;
+        alignas(T) u8 storage[sizeof(T)];
+    };
+
+    // Slabs form a singly-linked list. The slots follow the header.
+    struct slab {
+        slab* next;
+    };
+
+    static constexpr size_t slots_offset = (sizeof(slab) + alignof(slot) - 1) / alignof(slot) * alignof(slot);
+    static constexpr size_t slab_alignment = alignof(slot) > alignof(slab) ? alignof(slot) : alignof(slab);
+
+    [[nodiscard]] size_t slab_bytes() const { return slots_offset + m_slots_per_slab * sizeof(slot); }
+
+    void allocate_slab()
+    {
+        auto* new_slab = static_cast<slab*>(default_allocator {}.allocate(slab_bytes(), slab_alignment));
+        new_slab->next = m_slabs;
+        m_slabs = new_slab;
+        ++m_slab_count;
+        // Slots are handed out in order, so that a new slab is only touched as far as it is used.
+        m_bump = reinterpret_cast<slot*>(reinterpret_cast<u8*>(new_slab) + slots_offset);
+        m_bump_end = m_bump + m_slots_per_slab;
+    }
+
+    slot* m_free_list { nullptr };
+    slot* m_bump { nullptr };
+    slot* m_bump_end { nullptr };
+    slab* m_slabs { nullptr };
+    size_t m_slots_per_slab;
+    size_t m_slab_count { 0 };
+    size_t m_size { 0 };
+};
+
+// A handle to an object pool, which can be used as the allocator of unique_ptr<T>. The pool must outlive all pointers
+// using it.
+template <typename T>
+class pool_allocator {
+public:
+    explicit pool_allocator(object_pool<T>& pool)
+        : m_pool(&pool)
+    {
+    }
+
+    [[nodiscard]] void* allocate(size_t size, size_t alignment)
+    {
+        assert(size == sizeof(T) && alignment <= alignof(T));
+        return m_pool->allocate();
+    }
+
+    void deallocate(void* ptr, size_t size, size_t)
+    {
+        assert(size == sizeof(T));
+        m_pool->deallocate(ptr);
+    }
+
+    bool operator==(pool_allocator const& other) const { return m_pool == other.m_pool; }
+
+private:
+    object_pool<T>* m_pool;
+};
+
+static_assert(allocator<pool_allocator<int>>);
+
+}
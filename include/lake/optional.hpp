@@ -6,11 +6,20 @@
 #pragma once
 
 #include "extras.hpp"
+#include "type_traits.hpp"
 #include "types.hpp"
 #include <assert.h>
 
 namespace lake {
 
+template <typename T>
+class optional;
+
+template <typename T>
+inline constexpr bool is_optional_v = false;
+template <typename T>
+inline constexpr bool is_optional_v<optional<T>> = true;
+
 template <typename T>
 class optional {
 public:
@@ -36,8 +45,11 @@ public:
         new (slot()) T(forward<T>(value));
     }
 
+    // In-place construction from the constructor arguments of T.
+    // NOTE: This must not hijack copies and moves of optionals, which are a better match for non-const lvalues.
     template <typename... Args>
-    optional(Args... args) // NOLINT(google-explicit-constructor,cppcoreguidelines-pro-type-member-init)
+    optional(Args&&... args) // NOLINT(google-explicit-constructor,cppcoreguidelines-pro-type-member-init)
+        requires(!(sizeof...(Args) == 1 && (is_optional_v<remove_cvref_t<Args>> && ...)))
     {
         m_has_value = true;
         new (slot()) T(forward<Args>(args)...);
@@ -87,6 +99,7 @@ public:
             new (slot()) T(move(*other));
             m_has_value = true;
         }
+        return *this;
     }
 
     [[nodiscard]] bool has_value() const { return m_has_value; }
@@ -102,7 +115,7 @@ public:
     }
 
     template <typename... Args>
-    void emplace(Args... args)
+    void emplace(Args&&... args)
     {
         clear();
         new (slot()) T(forward<Args>(args)...);
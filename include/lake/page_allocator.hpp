@@ -0,0 +1,132 @@
+/*
+ * SPDX-FileCopyrightText: 2023 Max Wipfli <mail@maxwipfli.ch>
+ * SPDX-LicenseIdentifier: MIT
+ */
+
+#pragma once
+
+#include "allocator.hpp"
+#include "types.hpp"
+#include <assert.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace lake {
+
+// An allocator which maps whole pages from the operating system, for very large buffers (e.g. vector<T, page_allocator>
+// with hundreds of megabytes of elements).
+//
+// Allocations of at least huge_page_size bytes are aligned to huge pages and marked with MADV_HUGEPAGE, which reduces
+// TLB misses when they are accessed. On Linux, reallocate() uses mremap(), which moves the pages instead of copying their
+// contents, so growing a vector of trivially relocatable elements never copies them (and keeps it aligned to huge
+// pages). Shrinking unmaps the pages beyond the new size.
+//
+// NOTE: Every allocation takes at least one page and a system call, so this is not suitable for small buffers.
+struct page_allocator {
+    static constexpr size_t huge_page_size = 2 * 1024 * 1024;
+
+    [[nodiscard]] static size_t page_size() { return static_cast<size_t>(sysconf(_SC_PAGESIZE)); }
+
+    [[nodiscard]] void* allocate(size_t size, size_t alignment)
+    {
+        auto mapping_size = round_to_pages(size);
+        if (mapping_size >= huge_page_size && alignment < huge_page_size) {
+            alignment = huge_page_size;
+        }
+        auto* ptr = map(mapping_size, alignment);
+        if (mapping_size >= huge_page_size) {
+            advise_huge_pages(ptr, mapping_size);
+        }
+        return ptr;
+    }
+
+    void deallocate(void* ptr, size_t size, size_t)
+    {
+        munmap(ptr, round_to_pages(size));
+    }
+
+    [[nodiscard]] void* reallocate(void* ptr, size_t old_size, size_t new_size, size_t alignment)
+    {
+        auto old_mapping_size = round_to_pages(old_size);
+        auto new_mapping_size = round_to_pages(new_size);
+        if (new_mapping_size == old_mapping_size) {
+            return ptr;
+        }
+        if (new_mapping_size < old_mapping_size) {
+            // Give the pages beyond the new size back to the system, keeping the allocation in place.
+            munmap(static_cast<u8*>(ptr) + new_mapping_size, old_mapping_size - new_mapping_size);
+            return ptr;
+        }
+#ifdef __linux__
+        if (alignment <= page_size()) {
+            // The kernel moves the page table entries (if the mapping cannot be extended in place), so the contents are
+            // never copied.
+            if (new_mapping_size < huge_page_size) {
+                auto* new_ptr = mremap(ptr, old_mapping_size, new_mapping_size, MREMAP_MAYMOVE);
+                assert(new_ptr != MAP_FAILED);
+                return new_ptr;
+            }
+            // mremap() only keeps page alignment when moving, so large allocations are moved into a range reserved with
+            // huge page alignment. Without it, only the huge pages fully inside the allocation could be used.
+            void* new_ptr = MAP_FAILED;
+            if (reinterpret_cast<uintptr_t>(ptr) % huge_page_size == 0) {
+                new_ptr = mremap(ptr, old_mapping_size, new_mapping_size, 0);
+            }
+            if (new_ptr == MAP_FAILED) {
+                auto* reserved = map(new_mapping_size, huge_page_size);
+                new_ptr = mremap(ptr, old_mapping_size, new_mapping_size, MREMAP_MAYMOVE | MREMAP_FIXED, reserved);
+                assert(new_ptr != MAP_FAILED);
+            }
+            advise_huge_pages(new_ptr, new_mapping_size);
+            return new_ptr;
+        }
+#endif
+        auto* new_ptr = allocate(new_size, alignment);
+        __builtin_memcpy(new_ptr, ptr, old_size);
+        deallocate(ptr, old_size, alignment);
+        return new_ptr;
+    }
+
+    bool operator==(page_allocator const&) const { return true; }
+
+private:
+    static size_t round_to_pages(size_t size)
+    {
+        auto page = page_size();
+        return size == 0 ? page : (size + page - 1) & ~(page - 1);
+    }
+
+    // mmap() only guarantees page alignment, so larger alignments are obtained by mapping more than needed and unmapping
+    // the excess on both sides.
+    static void* map(size_t size, size_t alignment)
+    {
+        auto page = page_size();
+        auto padding = alignment > page ? alignment - page : 0;
+        auto* ptr = mmap(nullptr, size + padding, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        assert(ptr != MAP_FAILED);
+        if (padding == 0) {
+            return ptr;
+        }
+        auto address = reinterpret_cast<uintptr_t>(ptr);
+        auto aligned = (address + alignment - 1) & ~(alignment - 1);
+        if (aligned > address) {
+            munmap(ptr, aligned - address);
+        }
+        if (aligned + size < address + size + padding) {
+            munmap(reinterpret_cast<void*>(aligned + size), address + padding - aligned);
+        }
+        return reinterpret_cast<void*>(aligned);
+    }
+
+    static void advise_huge_pages([[maybe_unused]] void* ptr, [[maybe_unused]] size_t size)
+    {
+#ifdef MADV_HUGEPAGE
+        // This is only a hint, e.g. transparent huge pages may be disabled.
+        madvise(ptr, size, MADV_HUGEPAGE);
+#endif
+    }
+};
+
+static_assert(reallocating_allocator<page_allocator>);
+
+}
@@ -0,0 +1,239 @@
+/*
+ * SPDX-FileCopyrightText: 2023 Max Wipfli <mail@maxwipfli.ch>
+ * SPDX-LicenseIdentifier: MIT
+ */
+
+#pragma once
+
+#include "algorithm.hpp"
+#include "allocator.hpp"
+#include "extras.hpp"
+#include "span.hpp"
+#include "thread_pool.hpp"
+#include "type_traits.hpp"
+#include "types.hpp"
+#include "vector.hpp"
+#include <assert.h>
+
+namespace lake {
+
+// Parallel sample sort: The elements are distributed into buckets by splitters taken from a sorted random sample, and
+// the buckets are then sorted independently (with pdqsort, see sort()).
+//
+//  1. The input is cut into a few blocks per worker. Each block is classified in parallel, recording every element's
+//     bucket and counting the elements per bucket and block.
+//  2. Prefix sums over these counts give every block its own range within each bucket.
+//  3. The elements are moved into a scratch buffer of the same size, each block in parallel and without
+//     synchronization.
+//  4. The buckets are sorted in parallel, and moved back.
+//
+// Every splitter also gets a bucket of the elements equal to it, which needs no sorting. This keeps inputs with many
+// duplicates from ending up in a single bucket.
+template <typename T, typename Compare, bool Branchless>
+class parallel_sorter {
+public:
+    static void sort(thread_pool& pool, T* values, size_t size, Compare& less)
+    {
+        auto splitter_count = pool.size() * splitters_per_worker;
+        if (splitter_count > size / min_bucket_size) {
+            splitter_count = size / min_bucket_size;
+        }
+        if (pool.size() == 1 || splitter_count < 2) {
+            pdq_sorter<T, Compare, Branchless>::sort(values, values + size, less);
+            return;
+        }
+
+        // The splitters point into `values`, which is not modified until all elements are classified.
+        auto splitters = select_splitters(values, size, splitter_count, less);
+        auto bucket_count = 2 * splitters.size() + 1;
+
+        vector<u16> bucket_of;
+        bucket_of.resize_for_overwrite(size);
+        vector<size_t> offsets;
+        offsets.resize(bucket_count * pool.size() * blocks_per_worker);
+
+        vector<block> blocks;
+        auto block_size = (size + pool.size() * blocks_per_worker - 1) / (pool.size() * blocks_per_worker);
+        for (size_t begin = 0; begin < size; begin += block_size) {
+            auto end = begin + block_size < size ? begin + block_size : size;
+            blocks.push_back(block { begin, end, offsets.data() + blocks.size() * bucket_count });
+        }
+
+        pool.parallel_for(span<block>(blocks), 1, [&](span<block> chunk) {
+            for (auto& block : chunk) {
+                for (auto i = block.begin; i < block.end; ++i) {
+                    auto bucket = classify(values[i], splitters, less);
+                    bucket_of[i] = static_cast<u16>(bucket);
+                    block.offsets[bucket]++;
+                }
+            }
+        });
+
+        vector<bucket> buckets;
+        size_t offset = 0;
+        for (size_t index = 0; index < bucket_count; ++index) {
+            auto begin = offset;
+            for (auto& block : blocks) {
+                offset += exchange(block.offsets[index], offset);
+            }
+            if (offset > begin) {
+                buckets.push_back(bucket { begin, offset, index % 2 == 1 });
+            }
+        }
+
+        auto bytes = size * sizeof(T);
+        auto* scratch = static_cast<T*>(default_allocator {}.allocate(bytes, alignof(T)));
+        pool.parallel_for(span<block>(blocks), 1, [&](span<block> chunk) {
+            for (auto& block : chunk) {
+                for (auto i = block.begin; i < block.end; ++i) {
+                    new (&scratch[block.offsets[bucket_of[i]]++]) T(move(values[i]));
+                }
+            }
+        });
+
+        pool.parallel_for(span<bucket>(buckets), 1, [&](span<bucket> chunk) {
+            for (auto& bucket : chunk) {
+                if (!bucket.equal) {
+                    pdq_sorter<T, Compare, Branchless>::sort(scratch + bucket.begin, scratch + bucket.end, less);
+                }
+                for (auto i = bucket.begin; i < bucket.end; ++i) {
+                    values[i] = move(scratch[i]);
+                    scratch[i].~T();
+                }
+            }
+        });
+        default_allocator {}.deallocate(scratch, bytes, alignof(T));
+    }
+
+private:
+    // Each worker gets a few buckets and blocks, so that uneven ones are balanced by work stealing.
+    static constexpr size_t splitters_per_worker = 8;
+    static constexpr size_t blocks_per_worker = 4;
+    static constexpr size_t max_splitters = 1024;
+    static constexpr size_t oversampling = 16;
+    static constexpr size_t min_bucket_size = 4096;
+
+    struct block {
+        size_t begin;
+        size_t end;
+        // The number of elements in each bucket, and later the next position to move one to.
+        size_t* offsets;
+    };
+
+    struct bucket {
+        size_t begin;
+        size_t end;
+        bool equal;
+    };
+
+    // Sort a pseudo-random sample and take equally spaced elements from it, without duplicates.
+    static vector<T const*> select_splitters(T const* values, size_t size, size_t count, Compare& less)
+    {
+        if (count > max_splitters) {
+            count = max_splitters;
+        }
+        vector<T const*> sample;
+        u64 random_state = 0x9e3779b97f4a7c15ull ^ size;
+        for (size_t i = 0; i < count * oversampling; ++i) {
+            random_state ^= random_state << 13;
+            random_state ^= random_state >> 7;
+            random_state ^= random_state << 17;
+            sample.push_back(&values[random_state % size]);
+        }
+        lake::sort(sample.span(), [&](T const* first, T const* second) { return less(*first, *second); });
+
+        vector<T const*> splitters;
+        for (size_t i = oversampling / 2; i < sample.size(); i += oversampling) {
+            if (splitters.size() == 0 || less(*splitters[splitters.size() - 1], *sample[i])) {
+                splitters.push_back(sample[i]);
+            }
+        }
+        return splitters;
+    }
+
+    // Bucket 2 * i holds the elements between splitters i - 1 and i, and bucket 2 * i + 1 those equal to splitter i.
+    static size_t classify(T const& value, vector<T const*> const& splitters, Compare& less)
+    {
+        size_t first = 0;
+        size_t count = splitters.size();
+        while (count > 0) {
+            auto half = count / 2;
+            if (less(*splitters[first + half], value)) {
+                first += half + 1;
+                count -= half + 1;
+            } else {
+                count = half;
+            }
+        }
+        if (first < splitters.size() && !less(value, *splitters[first])) {
+            return 2 * first + 1;
+        }
+        return 2 * first;
+    }
+};
+
+// Call `fn(value)` for every element of `values`, in parallel.
+template <typename T, typename Fn>
+void parallel_for_each(thread_pool& pool, span<T> values, Fn const& fn)
+{
+    pool.parallel_for(values, pool.grain_for(values.size()), [&](span<T> chunk) {
+        for (auto& value : chunk) {
+            fn(value);
+        }
+    });
+}
+
+template <typename T, typename Fn>
+void parallel_for_each(span<T> values, Fn const& fn)
+{
+    parallel_for_each(thread_pool::global(), values, fn);
+}
+
+// Store `fn(input[i])` to `output[i]` for every element of `input`, in parallel. `output` must be at least as large as
+// `input`.
+template <typename T, typename U, typename Fn>
+void parallel_transform(thread_pool& pool, span<T> input, span<U> output, Fn const& fn)
+{
+    assert(output.size() >= input.size());
+    pool.parallel_for(input, pool.grain_for(input.size()), [&](span<T> chunk) {
+        auto* destination = output.data() + (chunk.data() - input.data());
+        for (size_t i = 0; i < chunk.size(); ++i) {
+            destination[i] = fn(chunk[i]);
+        }
+    });
+}
+
+template <typename T, typename U, typename Fn>
+void parallel_transform(span<T> input, span<U> output, Fn const& fn)
+{
+    parallel_transform(thread_pool::global(), input, output, fn);
+}
+
+// Sort the elements of `values` in parallel, like sort(). This needs temporary storage for a copy of the elements.
+template <typename T, typename Compare>
+void parallel_sort(thread_pool& pool, span<T> values, Compare less)
+{
+    parallel_sorter<T, Compare, false>::sort(pool, values.data(), values.size(), less);
+}
+
+template <typename T>
+void parallel_sort(thread_pool& pool, span<T> values)
+{
+    constexpr bool branchless = is_arithmetic_v<T> || is_pointer_v<T>;
+    lake::less less;
+    parallel_sorter<T, lake::less, branchless>::sort(pool, values.data(), values.size(), less);
+}
+
+template <typename T, typename Compare>
+void parallel_sort(span<T> values, Compare less)
+{
+    parallel_sort(thread_pool::global(), values, move(less));
+}
+
+template <typename T>
+void parallel_sort(span<T> values)
+{
+    parallel_sort(thread_pool::global(), values);
+}
+
+}
@@ -0,0 +1,289 @@
+/*
+ * SPDX-FileCopyrightText: 2023 Max Wipfli <mail@maxwipfli.ch>
+ * SPDX-LicenseIdentifier: MIT
+ */
+
+#pragma once
+
+#include "algorithm.hpp"
+#include "allocator.hpp"
+#include "extras.hpp"
+#include "span.hpp"
+#include "string_view.hpp"
+#include "type_traits.hpp"
+#include "types.hpp"
+#include <assert.h>
+
+namespace lake {
+
+// Least-significant-digit radix sort by integer keys. Each pass distributes the elements into buckets by one digit of
+// their key (of 8 or 11 bits), alternating between the values and a scratch buffer of the same size.
+//
+// The histograms of all digits are computed in a single pass over the input before the first distribution pass, and
+// passes in which all keys have the same digit (e.g. the upper bytes of small keys) are skipped. Small inputs are
+// sorted by insertion sort instead.
+template <typename T, typename Key, typename KeyType>
+class lsd_radix_sorter {
+    static_assert(__is_trivially_copyable(T), "radix sort copies elements between buffers");
+    static_assert(is_integral_v<KeyType>, "radix sort keys must be integers");
+
+public:
+    static void sort(T* values, T* scratch, size_t size, Key& key)
+    {
+        if (size < small_size) {
+            insertion_sort(values, size, key);
+            return;
+        }
+        // 32-bit counts halve the size of the histograms whenever they suffice.
+        if (size <= static_cast<u32>(-1)) {
+            sort_with_counts<u32>(values, scratch, size, key);
+        } else {
+            sort_with_counts<size_t>(values, scratch, size, key);
+        }
+    }
+
+private:
+    template <typename Count>
+    static void sort_with_counts(T* values, T* scratch, size_t size, Key& key)
+    {
+        Count counts[passes][radix] = {};
+        for (size_t i = 0; i < size; ++i) {
+            auto k = ordered_key(key(values[i]));
+            for (size_t pass = 0; pass < passes; ++pass) {
+                counts[pass][digit(k, pass)]++;
+            }
+        }
+
+        T* source = values;
+        T* destination = scratch;
+        for (size_t pass = 0; pass < passes; ++pass) {
+            auto& offsets = counts[pass];
+            // The elements are already ordered by this digit if they all share it.
+            if (offsets[digit(ordered_key(key(source[0])), pass)] == size) {
+                continue;
+            }
+            Count offset = 0;
+            for (auto& count : offsets) {
+                offset += exchange(count, offset);
+            }
+            // Scattering writes to up to `radix` places at once, whose cache lines are usually not cached anymore. The
+            // destination of an element a few iterations ahead is prefetched, so the writes don't wait for memory.
+            size_t i = 0;
+            for (; i + prefetch_distance < size; ++i) {
+                __builtin_prefetch(&destination[offsets[digit(ordered_key(key(source[i + prefetch_distance])), pass)]], 1);
+                auto d = digit(ordered_key(key(source[i])), pass);
+                destination[offsets[d]++] = source[i];
+            }
+            for (; i < size; ++i) {
+                auto d = digit(ordered_key(key(source[i])), pass);
+                destination[offsets[d]++] = source[i];
+            }
+            swap(source, destination);
+        }
+        if (source != values) {
+            __builtin_memcpy(static_cast<void*>(values), source, size * sizeof(T));
+        }
+    }
+
+    static constexpr size_t small_size = 64;
+    static constexpr size_t prefetch_distance = 16;
+    // 11-bit digits need fewer passes than bytes (e.g. 3 instead of 4 for 32-bit keys), while the histogram of a digit
+    // (8 KiB with 32-bit counts) still fits into the L1 cache. The histograms of all digits together take 24 KiB of
+    // stack for 32-bit keys and 48 KiB for 64-bit keys (twice as much for more than 2^32 elements).
+    static constexpr size_t digit_bits = sizeof(KeyType) > 2 ? 11 : 8;
+    static constexpr size_t radix = 1 << digit_bits;
+    static constexpr size_t passes = (8 * sizeof(KeyType) + digit_bits - 1) / digit_bits;
+
+    // Map keys to unsigned integers with the same order, by flipping the sign bit of signed ones (and dropping their
+    // sign extension).
+    static constexpr u64 ordered_key(KeyType key)
+    {
+        if constexpr (static_cast<KeyType>(-1) < static_cast<KeyType>(0)) {
+            constexpr auto sign_bit = 1ull << (8 * sizeof(KeyType) - 1);
+            return (static_cast<u64>(key) ^ sign_bit) & (sign_bit | (sign_bit - 1));
+        } else {
+            return static_cast<u64>(key);
+        }
+    }
+
+    static constexpr size_t digit(u64 key, size_t pass) { return (key >> (pass * digit_bits)) & (radix - 1); }
+
+    // Stable, like the radix sort itself.
+    static void insertion_sort(T* values, size_t size, Key& key)
+    {
+        for (size_t i = 1; i < size; ++i) {
+            T value = values[i];
+            auto value_key = key(value);
+            size_t hole = i;
+            while (hole > 0 && value_key < key(values[hole - 1])) {
+                values[hole] = values[hole - 1];
+                --hole;
+            }
+            values[hole] = value;
+        }
+    }
+};
+
+// Most-significant-digit radix sort for strings, with "digits" of 8 bytes: At each depth, the next 8 bytes of every
+// string are loaded into a big-endian integer, and the strings are sorted by these (with sort()). Groups of strings with
+// the same digit are then sorted recursively from the next digit on.
+//
+// The digits are cached next to the strings while sorting by them, so each string is only accessed once per depth
+// (instead of once per comparison), and long common prefixes (such as timestamps in log lines) are skipped 8 bytes at a
+// time.
+class string_radix_sorter {
+public:
+    static void sort(string_view* values, size_t size)
+    {
+        if (size < insertion_sort_threshold) {
+            insertion_sort(values, size, 0);
+            return;
+        }
+        auto bytes = size * sizeof(entry);
+        auto* entries = static_cast<entry*>(default_allocator {}.allocate(bytes, alignof(entry)));
+        sort(values, entries, size, 0);
+        default_allocator {}.deallocate(entries, bytes, alignof(entry));
+    }
+
+private:
+    static constexpr size_t insertion_sort_threshold = 16;
+    static constexpr size_t digit_size = 8;
+
+    // The bytes are zero-padded, so strings which end within the digit are told apart by their length.
+    struct digit {
+        u64 bytes;
+        size_t length;
+
+        bool operator<(digit const& other) const
+        {
+            return bytes < other.bytes || (bytes == other.bytes && length < other.length);
+        }
+    };
+
+    struct entry {
+        digit key;
+        string_view value;
+    };
+
+    // All strings in the range share their first `depth` bytes.
+    static void sort(string_view* values, entry* entries, size_t size, size_t depth)
+    {
+        while (size >= insertion_sort_threshold) {
+            for (size_t i = 0; i < size; ++i) {
+                new (&entries[i]) entry { digit_at(values[i], depth), values[i] };
+            }
+            lake::sort(span<entry>(entries, size), [](entry const& first, entry const& second) { return first.key < second.key; });
+            for (size_t i = 0; i < size; ++i) {
+                values[i] = entries[i].value;
+            }
+
+            size_t group_begin = 0;
+            size_t group_end = 1;
+            while (group_end < size && !(entries[group_begin].key < entries[group_end].key)) {
+                ++group_end;
+            }
+            if (group_end == size) {
+                // All strings share the digit, so continue with the next one (or stop if they all end within it).
+                if (entries[0].key.length < digit_size) {
+                    return;
+                }
+                depth += digit_size;
+                continue;
+            }
+
+            // Each group only uses the entries in its own range, so the remaining ones are not overwritten.
+            while (group_begin < size) {
+                if (group_end - group_begin > 1 && entries[group_begin].key.length == digit_size) {
+                    sort(values + group_begin, entries + group_begin, group_end - group_begin, depth + digit_size);
+                }
+                group_begin = group_end;
+                while (group_end < size && !(entries[group_begin].key < entries[group_end].key)) {
+                    ++group_end;
+                }
+            }
+            return;
+        }
+        insertion_sort(values, size, depth);
+    }
+
+    static digit digit_at(string_view value, size_t depth)
+    {
+        auto remaining = value.size() - depth;
+        u64 bytes = 0;
+        if (remaining >= digit_size) {
+            __builtin_memcpy(&bytes, value.data() + depth, digit_size);
+            return { __builtin_bswap64(bytes), digit_size };
+        }
+        if (remaining > 0) {
+            __builtin_memcpy(&bytes, value.data() + depth, remaining);
+        }
+        return { __builtin_bswap64(bytes), remaining };
+    }
+
+    // Compare the strings from `depth` on.
+    static bool less_from(string_view first, string_view second, size_t depth)
+    {
+        auto first_size = first.size() - depth;
+        auto second_size = second.size() - depth;
+        auto common_size = first_size < second_size ? first_size : second_size;
+        auto result = common_size > 0 ? __builtin_memcmp(first.data() + depth, second.data() + depth, common_size) : 0;
+        return result < 0 || (result == 0 && first_size < second_size);
+    }
+
+    static void insertion_sort(string_view* values, size_t size, size_t depth)
+    {
+        for (size_t i = 1; i < size; ++i) {
+            auto value = values[i];
+            size_t hole = i;
+            while (hole > 0 && less_from(value, values[hole - 1], depth)) {
+                values[hole] = values[hole - 1];
+                --hole;
+            }
+            values[hole] = value;
+        }
+    }
+};
+
+// Sort `values` by the integer keys returned by `key(value)`, using `scratch` (which must be at least as large) as
+// temporary storage. The sort is stable. Reusing the scratch buffer avoids an allocation per call.
+template <typename T, typename Key>
+void radix_sort(span<T> values, span<T> scratch, Key key)
+    requires requires(T const& value) { key(value); }
+{
+    assert(scratch.size() >= values.size());
+    using key_type = remove_cvref_t<decltype(key(values.data()[0]))>;
+    lsd_radix_sorter<T, Key, key_type>::sort(values.data(), scratch.data(), values.size(), key);
+}
+
+template <typename T, typename Key>
+void radix_sort(span<T> values, Key key)
+    requires requires(T const& value) { key(value); }
+{
+    auto bytes = values.size() * sizeof(T);
+    auto* scratch = static_cast<T*>(default_allocator {}.allocate(bytes, alignof(T)));
+    radix_sort(values, span<T>(scratch, values.size()), move(key));
+    default_allocator {}.deallocate(scratch, bytes, alignof(T));
+}
+
+// Sort integers in ascending order.
+template <typename T>
+void radix_sort(span<T> values, span<T> scratch)
+    requires is_integral_v<T>
+{
+    radix_sort(values, scratch, [](T value) { return value; });
+}
+
+template <typename T>
+void radix_sort(span<T> values)
+    requires is_integral_v<T>
+{
+    radix_sort(values, [](T value) { return value; });
+}
+
+// Sort strings in lexicographical order (by their bytes, as unsigned values).
+inline void radix_sort(span<string_view> values)
+{
+    string_radix_sorter::sort(values.data(), values.size());
+}
+
+}
@@ -0,0 +1,299 @@
+/*
+ * SPDX-FileCopyrightText: 2023 Max Wipfli <mail@maxwipfli.ch>
+ * SPDX-LicenseIdentifier: MIT
+ */
+
+#pragma once
+
+#include "allocator.hpp"
+#include "extras.hpp"
+#include "type_traits.hpp"
+#include "types.hpp"
+#include <assert.h>
+
+namespace lake {
+
+// A reference count, which starts at one (for the reference held by whoever created the object). The atomic variant
+// may be shared between threads.
+template <bool Atomic>
+class ref_counter {
+public:
+    void increment()
+    {
+        if constexpr (Atomic) {
+            // A new reference can only be created from an existing one, so no ordering is needed.
+            __atomic_fetch_add(&m_value, 1, __ATOMIC_RELAXED);
+        } else {
+            ++m_value;
+        }
+    }
+
+    // Returns true if this was the last reference.
+    [[nodiscard]] bool decrement()
+    {
+        if constexpr (Atomic) {
+            // All uses of the object through other references must happen before it is destroyed.
+            if (__atomic_fetch_sub(&m_value, 1, __ATOMIC_RELEASE) == 1) {
+                __atomic_thread_fence(__ATOMIC_ACQUIRE);
+                return true;
+            }
+            return false;
+        } else {
+            return --m_value == 0;
+        }
+    }
+
+    [[nodiscard]] u32 value() const
+    {
+        if constexpr (Atomic) {
+            return __atomic_load_n(&m_value, __ATOMIC_RELAXED);
+        } else {
+            return m_value;
+        }
+    }
+
+private:
+    u32 m_value { 1 };
+};
+
+// Base class for intrusively reference-counted types, which keep their count inside the object. Objects are created with
+// `new` (see make_ref_counted) and destroyed with `delete` once the last ref_ptr to them is gone.
+template <bool Atomic>
+class basic_ref_counted {
+public:
+    void ref() const { m_ref_count.increment(); }
+    // Returns true if this was the last reference, in which case the caller has to destroy the object.
+    [[nodiscard]] bool unref() const { return m_ref_count.decrement(); }
+    [[nodiscard]] u32 ref_count() const { return m_ref_count.value(); }
+
+protected:
+    basic_ref_counted() = default;
+    ~basic_ref_counted() = default;
+
+    // Copies of an object are not referenced by anyone yet, so they start with a fresh count.
+    basic_ref_counted(basic_ref_counted const&) { }
+    basic_ref_counted& operator=(basic_ref_counted const&) { return *this; }
+
+private:
+    mutable ref_counter<Atomic> m_ref_count;
+};
+
+using ref_counted = basic_ref_counted<false>;
+using atomic_ref_counted = basic_ref_counted<true>;
+
+template <typename T>
+inline constexpr bool is_atomic_ref_counted_v = __is_base_of(atomic_ref_counted, T);
+template <typename T>
+inline constexpr bool is_intrusively_ref_counted_v = __is_base_of(ref_counted, T) || is_atomic_ref_counted_v<T>;
+
+// A shared pointer to an object with a reference count. The count is either part of the object itself (if it derives
+// from ref_counted or atomic_ref_counted), or is placed right in front of the object by make_ref_counted. Either way,
+// there is no separate allocation for the count.
+//
+// `Atomic` selects an atomic count for objects which are shared between threads. For intrusively counted types, it must
+// match the base class (which is the default).
+//
+// NOTE: Copies increment the count, while moves just transfer the pointer.
+template <typename T, bool Atomic = is_atomic_ref_counted_v<T>>
+class ref_ptr {
+    static constexpr bool is_intrusive = is_intrusively_ref_counted_v<T>;
+    static_assert(!is_intrusive || is_atomic_ref_counted_v<T> == Atomic, "Atomic must match the base class of intrusively counted types");
+
+    template <typename U, bool OtherAtomic>
+    friend class ref_ptr;
+
+public:
+    // Take over the reference held by the creator of `ptr`, without incrementing the count.
+    static ref_ptr adopt(T* ptr) requires is_intrusive
+    {
+        return ref_ptr(ptr, adopt_tag {});
+    }
+
+    template <typename... Args>
+    static ref_ptr create(Args&&... args)
+    {
+        if constexpr (is_intrusive) {
+            return adopt(new T(forward<Args>(args)...));
+        } else {
+            auto* box = default_allocator {}.allocate(box_size, box_alignment);
+            new (box) ref_counter<Atomic>();
+            auto* ptr = new (static_cast<u8*>(box) + value_offset) T(forward<Args>(args)...);
+            return ref_ptr(ptr, adopt_tag {});
+        }
+    }
+
+    ref_ptr() = default;
+
+    // Add a reference to an existing object, e.g. to obtain a ref_ptr from `this`.
+    explicit ref_ptr(T* ptr) requires is_intrusive
+        : m_ptr(ptr)
+    {
+        if (m_ptr) {
+            ref(m_ptr);
+        }
+    }
+
+    ~ref_ptr() { clear(); }
+
+    ref_ptr(ref_ptr const& other)
+        : m_ptr(other.m_ptr)
+    {
+        if (m_ptr) {
+            ref(m_ptr);
+        }
+    }
+    ref_ptr& operator=(ref_ptr const& other)
+    {
+        ref_ptr tmp(other);
+        swap(tmp);
+        return *this;
+    }
+
+    ref_ptr(ref_ptr&& other) noexcept
+        : m_ptr(exchange(other.m_ptr, nullptr))
+    {
+    }
+    ref_ptr& operator=(ref_ptr&& other) noexcept
+    {
+        ref_ptr tmp(move(other));
+        swap(tmp);
+        return *this;
+    }
+
+    // Conversion to a pointer to const, and (for intrusively counted types) to a pointer to a base class.
+    // NOTE: The object is destroyed through the type it was created as, so base classes need a virtual destructor.
+    template <typename U>
+    ref_ptr(ref_ptr<U, Atomic> const& other) // NOLINT(google-explicit-constructor)
+        requires(convertible_to<U*, T*> && (is_intrusive || is_same_v<U const, T>))
+        : m_ptr(other.m_ptr)
+    {
+        if (m_ptr) {
+            ref(m_ptr);
+        }
+    }
+    template <typename U>
+    ref_ptr(ref_ptr<U, Atomic>&& other) // NOLINT(google-explicit-constructor)
+        requires(convertible_to<U*, T*> && (is_intrusive || is_same_v<U const, T>))
+        : m_ptr(exchange(other.m_ptr, nullptr))
+    {
+    }
+
+    T* ptr() const { return m_ptr; }
+    T& operator*() const
+    {
+        assert(m_ptr);
+        return *m_ptr;
+    }
+    T* operator->() const
+    {
+        assert(m_ptr);
+        return m_ptr;
+    }
+
+    operator bool() const { return m_ptr; } // NOLINT(google-explicit-constructor)
+
+    // The number of ref_ptrs (and other references) to the object, or zero if this is null.
+    [[nodiscard]] u32 ref_count() const
+    {
+        if (!m_ptr) {
+            return 0;
+        }
+        if constexpr (is_intrusive) {
+            return m_ptr->ref_count();
+        } else {
+            return count(m_ptr).value();
+        }
+    }
+
+    void swap(ref_ptr& other)
+    {
+        auto* tmp = m_ptr;
+        m_ptr = other.m_ptr;
+        other.m_ptr = tmp;
+    }
+
+    void clear()
+    {
+        auto* ptr = exchange(m_ptr, nullptr);
+        if (!ptr) {
+            return;
+        }
+        if constexpr (is_intrusive) {
+            if (ptr->unref()) {
+                delete ptr;
+            }
+        } else {
+            if (count(ptr).decrement()) {
+                auto* box = reinterpret_cast<u8*>(const_cast<remove_const_t<T>*>(ptr)) - value_offset;
+                ptr->~T();
+                default_allocator {}.deallocate(box, box_size, box_alignment);
+            }
+        }
+    }
+
+    template <typename U, bool OtherAtomic>
+    bool operator==(ref_ptr<U, OtherAtomic> const& other) const
+    {
+        return m_ptr == other.m_ptr;
+    }
+
+private:
+    struct adopt_tag {
+    };
+
+    ref_ptr(T* ptr, adopt_tag)
+        : m_ptr(ptr)
+    {
+    }
+
+    // Without intrusive counting, the count and the object share one allocation (the "box"), with the count first.
+    static constexpr size_t value_offset = (sizeof(ref_counter<Atomic>) + alignof(T) - 1) / alignof(T) * alignof(T);
+    static constexpr size_t box_size = value_offset + sizeof(T);
+    static constexpr size_t box_alignment = alignof(T) > alignof(ref_counter<Atomic>) ? alignof(T) : alignof(ref_counter<Atomic>);
+
+    static ref_counter<Atomic>& count(T* ptr) requires(!is_intrusive)
+    {
+        auto* box = reinterpret_cast<u8*>(const_cast<remove_const_t<T>*>(ptr)) - value_offset;
+        return *reinterpret_cast<ref_counter<Atomic>*>(box);
+    }
+
+    static void ref(T* ptr)
+    {
+        if constexpr (is_intrusive) {
+            ptr->ref();
+        } else {
+            count(ptr).increment();
+        }
+    }
+
+    T* m_ptr { nullptr };
+};
+
+template <typename T>
+using atomic_ref_ptr = ref_ptr<T, true>;
+
+// ref_ptr only holds a pointer, so it can be relocated by copying its bytes.
+template <typename T, bool Atomic>
+struct is_trivially_relocatable<ref_ptr<T, Atomic>> : true_type {
+};
+
+template <typename T>
+ref_ptr<T> adopt_ref(T* ptr)
+{
+    return ref_ptr<T>::adopt(ptr);
+}
+
+// Create a reference-counted object. The object and its count are placed in a single allocation.
+template <typename T, typename... Args>
+ref_ptr<T> make_ref_counted(Args&&... args)
+{
+    return ref_ptr<T>::create(forward<Args>(args)...);
+}
+
+template <typename T, typename... Args>
+atomic_ref_ptr<T> make_atomic_ref_counted(Args&&... args)
+{
+    return atomic_ref_ptr<T>::create(forward<Args>(args)...);
+}
+
+}
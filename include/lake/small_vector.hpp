@@ -0,0 +1,315 @@
+/*
+ * SPDX-FileCopyrightText: 2023 Max Wipfli <mail@maxwipfli.ch>
+ * SPDX-LicenseIdentifier: MIT
+ */
+
+#pragma once
+
+#include "allocator.hpp"
+#include "extras.hpp"
+#include "hash.hpp"
+#include "iterator.hpp"
+#include "span.hpp"
+#include "type_traits.hpp"
+#include "types.hpp"
+#include <assert.h>
+#include <initializer_list>
+
+namespace lake {
+
+// A vector which stores up to `InlineCapacity` elements inside the object itself, and only allocates from `Alloc` once
+// it grows beyond that.
+template <typename T, size_t InlineCapacity, allocator Alloc = default_allocator>
+class small_vector {
+    static_assert(InlineCapacity > 0, "use vector<T> if there is no inline capacity");
+
+public:
+    // Don't use `= default` to avoid warnings about the uninitialized `m_inline` storage, see optional<T>.
+    small_vector() { } // NOLINT(cppcoreguidelines-pro-type-member-init,modernize-use-equals-default)
+
+    explicit small_vector(Alloc allocator) // NOLINT(cppcoreguidelines-pro-type-member-init)
+        : m_allocator(move(allocator))
+    {
+    }
+
+    // span (copy) constructor/assignment operators
+    template <typename U>
+    small_vector(lake::span<U> span, Alloc allocator = {}) // NOLINT(google-explicit-constructor,cppcoreguidelines-pro-type-member-init)
+        : m_allocator(move(allocator))
+    {
+        reserve(span.size());
+        for (size_t i = 0; i < span.size(); ++i) {
+            new (&m_data[i]) T(span[i]);
+        }
+        m_size = span.size();
+    }
+    template <typename U>
+    small_vector& operator=(lake::span<U> span)
+    {
+        // Use the copy assignment operator for all objects that already exist, and the copy constructor for all "new"
+        // objects.
+        while (m_size > span.size()) {
+            pop_back();
+        }
+        reserve(span.size());
+        for (size_t i = 0; i < m_size; ++i) {
+            m_data[i] = span[i];
+        }
+        for (size_t i = m_size; i < span.size(); ++i) {
+            new (&m_data[i]) T(span[i]);
+        }
+        m_size = span.size();
+        return *this;
+    }
+
+    // initializer list constructor/assignment operators (via span)
+    template <typename U>
+    small_vector(std::initializer_list<U> initializer_list, Alloc allocator = {})
+        : small_vector(lake::span<U const>(initializer_list), move(allocator))
+    {
+    }
+    template <typename U>
+    small_vector& operator=(std::initializer_list<U> initializer_list)
+    {
+        *this = lake::span<U const>(initializer_list);
+        return *this;
+    }
+
+    // copy constructor/assignment operator
+    // NOTE: Copies use the allocator of the vector they are copied from.
+    template <typename U, size_t OtherInlineCapacity, typename OtherAlloc>
+    explicit small_vector(small_vector<U, OtherInlineCapacity, OtherAlloc> const& other)
+        : small_vector(other.span(), other.allocator())
+    {
+    }
+    template <typename U, size_t OtherInlineCapacity, typename OtherAlloc>
+    small_vector& operator=(small_vector<U, OtherInlineCapacity, OtherAlloc> const& other)
+    {
+        *this = other.span();
+        return *this;
+    }
+
+    // move constructor/assignment operator
+    // NOTE: Heap storage is taken over from `other`, while inline elements have to be moved one by one.
+    small_vector(small_vector&& other) noexcept // NOLINT(cppcoreguidelines-pro-type-member-init)
+        : m_allocator(move(other.m_allocator))
+    {
+        take_from(other);
+    }
+    small_vector& operator=(small_vector&& other) noexcept
+    {
+        if (this == &other) {
+            return *this;
+        }
+        clear();
+        m_allocator = move(other.m_allocator);
+        take_from(other);
+        return *this;
+    }
+
+    ~small_vector() { clear(); }
+
+    static small_vector filled(size_t count, T const& value, Alloc allocator = {})
+    {
+        small_vector vec(move(allocator));
+        vec.reserve(count);
+        for (size_t i = 0; i < count; ++i) {
+            vec.push_back(value);
+        }
+        return vec;
+    }
+
+    [[nodiscard]] T* data() { return m_data; }
+    [[nodiscard]] T const* data() const { return m_data; }
+    [[nodiscard]] size_t capacity() const { return m_capacity; }
+    [[nodiscard]] size_t size() const { return m_size; }
+    [[nodiscard]] bool empty() const { return m_size == 0; }
+    [[nodiscard]] bool is_inline() const { return m_data == inline_data(); }
+    [[nodiscard]] static constexpr size_t inline_capacity() { return InlineCapacity; }
+    [[nodiscard]] Alloc const& allocator() const { return m_allocator; }
+
+    // spans
+    [[nodiscard]] ::lake::span<T> span() { return { m_data, m_size }; }
+    [[nodiscard]] ::lake::span<T const> span() const { return { m_data, m_size }; }
+    [[nodiscard]] ::lake::span<T> subspan(size_t start, size_t size) { return span().subspan(start, size); }
+    [[nodiscard]] ::lake::span<T const> subspan(size_t start, size_t size) const { return span().subspan(start, size); }
+    [[nodiscard]] operator ::lake::span<T>() { return span(); } // NOLINT(google-explicit-constructor)
+    [[nodiscard]] operator ::lake::span<T const>() const { return span(); } // NOLINT(google-explicit-constructor)
+
+    // element access
+    [[nodiscard]] T& at(size_t index)
+    {
+        assert(index < m_size);
+        return m_data[index];
+    }
+    [[nodiscard]] T const& at(size_t index) const
+    {
+        assert(index < m_size);
+        return m_data[index];
+    }
+    [[nodiscard]] T& operator[](size_t index) { return at(index); }
+    [[nodiscard]] T const& operator[](size_t index) const { return at(index); }
+    [[nodiscard]] T& front() { return at(0); }
+    [[nodiscard]] T const& front() const { return at(0); }
+    [[nodiscard]] T& back() { return at(m_size - 1); }
+    [[nodiscard]] T const& back() const { return at(m_size - 1); }
+
+    // iterators
+    using iterator = lake::contiguous_iterator<T>;
+    using const_iterator = lake::contiguous_iterator<T const>;
+    [[nodiscard]] iterator begin() { return iterator(m_data); }
+    [[nodiscard]] const_iterator begin() const { return const_iterator(m_data); }
+    [[nodiscard]] iterator end() { return iterator(m_data + m_size); }
+    [[nodiscard]] const_iterator end() const { return const_iterator(m_data + m_size); }
+
+    template <typename U>
+    void push_back(U const& element)
+    {
+        reserve(m_size + 1);
+        new (&m_data[m_size]) T(forward<U const&>(element));
+        ++m_size;
+    }
+
+    void push_back(T&& element)
+    {
+        reserve(m_size + 1);
+        new (&m_data[m_size]) T(forward<T>(element));
+        ++m_size;
+    }
+
+    template <typename... Args>
+    void emplace_back(Args&&... args)
+    {
+        reserve(m_size + 1);
+        new (&m_data[m_size]) T(forward<Args>(args)...);
+        ++m_size;
+    }
+
+    void pop_back()
+    {
+        assert(m_size >= 1);
+        --m_size;
+        m_data[m_size].~T();
+    }
+
+    void reserve(size_t new_capacity)
+    {
+        if (new_capacity <= m_capacity)
+            return;
+        reallocate(new_capacity);
+    }
+
+    // Destroy all elements and release heap storage, if any.
+    void clear()
+    {
+        for (T& elem : *this) {
+            elem.~T();
+        }
+        m_size = 0;
+
+        if (!is_inline()) {
+            deallocate_buffer(m_data, m_capacity);
+            m_data = inline_data();
+            m_capacity = InlineCapacity;
+        }
+    }
+
+    void swap(small_vector& other)
+    {
+        small_vector tmp = move(other);
+        other = move(*this);
+        *this = move(tmp);
+    }
+
+    template <typename U, size_t OtherInlineCapacity, typename OtherAlloc>
+    bool operator==(small_vector<U, OtherInlineCapacity, OtherAlloc> const& other) const
+    {
+        return span() == other.span();
+    }
+
+    template <typename U>
+    bool operator==(::lake::span<U> const& other) const
+    {
+        return span() == other;
+    }
+
+private:
+    T* inline_data() { return reinterpret_cast<T*>(&m_inline); }
+    T const* inline_data() const { return reinterpret_cast<T const*>(&m_inline); }
+
+    // Move `count` elements from `source` into the uninitialized `destination`, and destroy them in `source`.
+    static void relocate(T* destination, T* source, size_t count)
+    {
+        if constexpr (is_trivially_relocatable_v<T>) {
+            if (count > 0) {
+                __builtin_memcpy(static_cast<void*>(destination), source, count * sizeof(T));
+            }
+        } else {
+            for (size_t i = 0; i < count; ++i) {
+                new (&destination[i]) T(move(source[i]));
+                source[i].~T();
+            }
+        }
+    }
+
+    // Take over the elements of `other`, which is left empty. Assumes that this vector is empty and inline.
+    void take_from(small_vector& other)
+    {
+        if (other.is_inline()) {
+            relocate(m_data, other.m_data, other.m_size);
+        } else {
+            m_data = exchange(other.m_data, other.inline_data());
+            m_capacity = exchange(other.m_capacity, InlineCapacity);
+        }
+        m_size = exchange(other.m_size, 0);
+    }
+
+    T* allocate_buffer(size_t capacity)
+    {
+        return static_cast<T*>(m_allocator.allocate(capacity * sizeof(T), alignof(T)));
+    }
+
+    void deallocate_buffer(T* buffer, size_t capacity)
+    {
+        m_allocator.deallocate(buffer, capacity * sizeof(T), alignof(T));
+    }
+
+    void reallocate(size_t new_capacity)
+    {
+        assert(m_size <= new_capacity);
+        auto old_capacity = exchange(m_capacity, bit_ceil(new_capacity));
+        if (is_inline()) {
+            auto* new_data = allocate_buffer(m_capacity);
+            relocate(new_data, m_data, m_size);
+            m_data = new_data;
+            return;
+        }
+        if constexpr (is_trivially_relocatable_v<T> && reallocating_allocator<Alloc>) {
+            auto* ptr = m_allocator.reallocate(m_data, old_capacity * sizeof(T), m_capacity * sizeof(T), alignof(T));
+            m_data = static_cast<T*>(ptr);
+        } else {
+            auto* new_data = allocate_buffer(m_capacity);
+            relocate(new_data, m_data, m_size);
+            deallocate_buffer(m_data, old_capacity);
+            m_data = new_data;
+        }
+    }
+
+    // NOTE: m_data points into the object itself while the elements are stored inline, so small_vector is not
+    //       trivially relocatable.
+    T* m_data { inline_data() };
+    size_t m_capacity { InlineCapacity };
+    size_t m_size { 0 };
+    alignas(T) u8 m_inline[InlineCapacity * sizeof(T)];
+    [[no_unique_address]] Alloc m_allocator;
+};
+
+template <typename T, size_t InlineCapacity, typename Alloc>
+struct hash<small_vector<T, InlineCapacity, Alloc>> {
+    constexpr void operator()(hash_state& h, small_vector<T, InlineCapacity, Alloc> const& value)
+    {
+        h.hash(value.span());
+    }
+};
+
+}
@@ -0,0 +1,178 @@
+/*
+ * SPDX-FileCopyrightText: 2023 Max Wipfli <mail@maxwipfli.ch>
+ * SPDX-LicenseIdentifier: MIT
+ */
+
+#pragma once
+
+#include "allocator.hpp"
+#include "atomic.hpp"
+#include "extras.hpp"
+#include "optional.hpp"
+#include "span.hpp"
+#include "type_traits.hpp"
+#include "types.hpp"
+#include <assert.h>
+
+namespace lake {
+
+// A bounded, lock-free queue for exactly one producer and one consumer thread.
+//
+// The elements live in a ring buffer with a power-of-two number of slots, which are addressed by ever-increasing head
+// and tail counters (so that a full queue can be told apart from an empty one without wasting a slot). Only the producer
+// writes the tail and only the consumer writes the head, and the two are on separate cache lines.
+//
+// Each side also keeps a cached copy of the other side's counter, and only reloads it when the cached value suggests
+// that there is not enough room (or not enough elements). Most of the time, the two threads thus don't touch each
+// other's cache lines at all. The batch operations push_n() and pop_n() publish a whole span of elements with a single counter update.
+template <typename T, allocator Alloc = default_allocator>
+class spsc_queue {
+public:
+    // The capacity is rounded up to a power of two.
+    explicit spsc_queue(size_t capacity, Alloc allocator = {})
+        : m_allocator(move(allocator))
+    {
+        assert(capacity > 0);
+        m_capacity = bit_ceil(capacity);
+        m_slots = static_cast<T*>(m_allocator.allocate(m_capacity * sizeof(T), alignof(T)));
+    }
+
+    ~spsc_queue()
+    {
+        auto tail = m_producer.tail.load(memory_order::relaxed);
+        for (auto i = m_consumer.head.load(memory_order::relaxed); i != tail; ++i) {
+            slot(i).~T();
+        }
+        m_allocator.deallocate(m_slots, m_capacity * sizeof(T), alignof(T));
+    }
+
+    spsc_queue(spsc_queue const&) = delete;
+    spsc_queue& operator=(spsc_queue const&) = delete;
+    spsc_queue(spsc_queue&&) = delete;
+    spsc_queue& operator=(spsc_queue&&) = delete;
+
+    [[nodiscard]] size_t capacity() const { return m_capacity; }
+
+    // The number of elements, which may be outdated as soon as it is returned (unless called by the producer or
+    // consumer, which can rely on it being a lower or upper bound, respectively).
+    [[nodiscard]] size_t size() const
+    {
+        auto head = m_consumer.head.load(memory_order::acquire);
+        auto tail = m_producer.tail.load(memory_order::acquire);
+        return tail - head;
+    }
+    [[nodiscard]] bool empty() const { return size() == 0; }
+
+    // producer
+
+    // Construct an element at the end of the queue, or return false if it is full.
+    template <typename... Args>
+    [[nodiscard]] bool try_emplace(Args&&... args)
+    {
+        auto tail = m_producer.tail.load(memory_order::relaxed);
+        if (free_slots(tail, 1) == 0) {
+            return false;
+        }
+        new (&slot(tail)) T(forward<Args>(args)...);
+        m_producer.tail.store(tail + 1, memory_order::release);
+        return true;
+    }
+
+    [[nodiscard]] bool try_push(T const& value) { return try_emplace(value); }
+    [[nodiscard]] bool try_push(T&& value) { return try_emplace(move(value)); }
+
+    // Copy as many elements from the front of `values` as fit into the queue, and return their number.
+    template <typename U>
+    size_t push_n(span<U> values)
+    {
+        auto tail = m_producer.tail.load(memory_order::relaxed);
+        auto count = free_slots(tail, values.size());
+        if (count > values.size()) {
+            count = values.size();
+        }
+        for (size_t i = 0; i < count; ++i) {
+            new (&slot(tail + i)) T(values[i]);
+        }
+        m_producer.tail.store(tail + count, memory_order::release);
+        return count;
+    }
+
+    // consumer
+
+    // Remove the element at the front of the queue, if there is one.
+    [[nodiscard]] optional<T> try_pop()
+    {
+        auto head = m_consumer.head.load(memory_order::relaxed);
+        if (available(head, 1) == 0) {
+            return {};
+        }
+        optional<T> result(move(slot(head)));
+        slot(head).~T();
+        m_consumer.head.store(head + 1, memory_order::release);
+        return result;
+    }
+
+    // Move up to `output.size()` elements from the front of the queue into `output`, and return their number.
+    size_t pop_n(span<T> output)
+    {
+        auto head = m_consumer.head.load(memory_order::relaxed);
+        auto count = available(head, output.size());
+        if (count > output.size()) {
+            count = output.size();
+        }
+        for (size_t i = 0; i < count; ++i) {
+            output[i] = move(slot(head + i));
+            slot(head + i).~T();
+        }
+        m_consumer.head.store(head + count, memory_order::release);
+        return count;
+    }
+
+private:
+    T& slot(u64 index) { return m_slots[index & (m_capacity - 1)]; }
+
+    // The number of slots the producer can fill, reloading the head only if the cached one says there are fewer than
+    // `wanted`. The acquire load ensures that the consumer is done with the slots it has released.
+    size_t free_slots(u64 tail, size_t wanted)
+    {
+        auto free = m_capacity - (tail - m_producer.cached_head);
+        if (free < wanted) {
+            m_producer.cached_head = m_consumer.head.load(memory_order::acquire);
+            free = m_capacity - (tail - m_producer.cached_head);
+        }
+        return free;
+    }
+
+    // The number of elements the consumer can take, reloading the tail only if the cached one says there are fewer than
+    // `wanted`.
+    size_t available(u64 head, size_t wanted)
+    {
+        auto count = m_consumer.cached_tail - head;
+        if (count < wanted) {
+            m_consumer.cached_tail = m_producer.tail.load(memory_order::acquire);
+            count = m_consumer.cached_tail - head;
+        }
+        return count;
+    }
+
+    // Written by the producer only.
+    struct alignas(64) producer_state {
+        atomic<u64> tail { 0 };
+        u64 cached_head { 0 };
+    };
+
+    // Written by the consumer only.
+    struct alignas(64) consumer_state {
+        atomic<u64> head { 0 };
+        u64 cached_tail { 0 };
+    };
+
+    producer_state m_producer;
+    consumer_state m_consumer;
+    // Read-only after construction, and thus shared by both sides without contention.
+    alignas(64) T* m_slots { nullptr };
+    size_t m_capacity { 0 };
+    [[no_unique_address]] Alloc m_allocator;
+};
+
+}
@@ -0,0 +1,261 @@
+/*
+ * SPDX-FileCopyrightText: 2023 Max Wipfli <mail@maxwipfli.ch>
+ * SPDX-LicenseIdentifier: MIT
+ */
+
+#pragma once
+
+#include "extras.hpp"
+#include "hash.hpp"
+#include "iterator.hpp"
+#include "span.hpp"
+#include "type_traits.hpp"
+#include "types.hpp"
+#include <assert.h>
+#include <initializer_list>
+
+namespace lake {
+
+// A vector with a fixed maximum capacity, whose elements are stored inside the object itself. It never allocates.
+//
+// For trivial element types, the elements are stored in a plain array, which makes static_vector usable in constant
+// expressions. Other element types are constructed in place in uninitialized storage.
+template <typename T, size_t Capacity>
+class static_vector {
+    static_assert(Capacity > 0, "static_vector must have a non-zero capacity");
+
+    static constexpr bool is_trivial = __is_trivial(T);
+
+public:
+    constexpr static_vector() = default;
+
+    // span (copy) constructor/assignment operators
+    // NOTE: The span must fit into the capacity.
+    template <typename U>
+    constexpr static_vector(lake::span<U> span) // NOLINT(google-explicit-constructor)
+    {
+        assert(span.size() <= Capacity);
+        for (size_t i = 0; i < span.size(); ++i) {
+            construct_at(i, span[i]);
+        }
+        m_size = span.size();
+    }
+    template <typename U>
+    constexpr static_vector& operator=(lake::span<U> span)
+    {
+        assert(span.size() <= Capacity);
+        clear();
+        for (size_t i = 0; i < span.size(); ++i) {
+            construct_at(i, span[i]);
+        }
+        m_size = span.size();
+        return *this;
+    }
+
+    // initializer list constructor/assignment operator (via span)
+    template <typename U>
+    constexpr static_vector(std::initializer_list<U> initializer_list)
+        : static_vector(lake::span<U const>(initializer_list))
+    {
+    }
+    template <typename U>
+    constexpr static_vector& operator=(std::initializer_list<U> initializer_list)
+    {
+        *this = lake::span<U const>(initializer_list);
+        return *this;
+    }
+
+    // copy/move constructors and assignment operators
+    // NOTE: These are trivial for trivial element types, so that static_vector is trivially copyable as well.
+    constexpr static_vector(static_vector const&) requires is_trivial = default;
+    constexpr static_vector(static_vector const& other) requires(!is_trivial)
+        : static_vector(other.span())
+    {
+    }
+    constexpr static_vector& operator=(static_vector const&) requires is_trivial = default;
+    constexpr static_vector& operator=(static_vector const& other) requires(!is_trivial)
+    {
+        if (this != &other) {
+            *this = other.span();
+        }
+        return *this;
+    }
+    constexpr static_vector(static_vector&&) requires is_trivial = default;
+    constexpr static_vector(static_vector&& other) requires(!is_trivial)
+    {
+        for (size_t i = 0; i < other.m_size; ++i) {
+            construct_at(i, move(other[i]));
+        }
+        m_size = other.m_size;
+        other.clear();
+    }
+    constexpr static_vector& operator=(static_vector&&) requires is_trivial = default;
+    constexpr static_vector& operator=(static_vector&& other) requires(!is_trivial)
+    {
+        if (this == &other) {
+            return *this;
+        }
+        clear();
+        for (size_t i = 0; i < other.m_size; ++i) {
+            construct_at(i, move(other[i]));
+        }
+        m_size = other.m_size;
+        other.clear();
+        return *this;
+    }
+
+    constexpr ~static_vector() requires is_trivial = default;
+    constexpr ~static_vector() requires(!is_trivial) { clear(); }
+
+    [[nodiscard]] constexpr T* data() { return m_storage.data(); }
+    [[nodiscard]] constexpr T const* data() const { return m_storage.data(); }
+    [[nodiscard]] static constexpr size_t capacity() { return Capacity; }
+    [[nodiscard]] constexpr size_t size() const { return m_size; }
+    [[nodiscard]] constexpr bool empty() const { return m_size == 0; }
+    [[nodiscard]] constexpr bool full() const { return m_size == Capacity; }
+
+    // spans
+    [[nodiscard]] constexpr ::lake::span<T> span() { return { data(), m_size }; }
+    [[nodiscard]] constexpr ::lake::span<T const> span() const { return { data(), m_size }; }
+    [[nodiscard]] constexpr ::lake::span<T> subspan(size_t start, size_t size) { return span().subspan(start, size); }
+    [[nodiscard]] constexpr ::lake::span<T const> subspan(size_t start, size_t size) const { return span().subspan(start, size); }
+    [[nodiscard]] constexpr operator ::lake::span<T>() { return span(); } // NOLINT(google-explicit-constructor)
+    [[nodiscard]] constexpr operator ::lake::span<T const>() const { return span(); } // NOLINT(google-explicit-constructor)
+
+    // element access
+    [[nodiscard]] constexpr T& at(size_t index)
+    {
+        assert(index < m_size);
+        return data()[index];
+    }
+    [[nodiscard]] constexpr T const& at(size_t index) const
+    {
+        assert(index < m_size);
+        return data()[index];
+    }
+    [[nodiscard]] constexpr T& operator[](size_t index) { return at(index); }
+    [[nodiscard]] constexpr T const& operator[](size_t index) const { return at(index); }
+    [[nodiscard]] constexpr T& front() { return at(0); }
+    [[nodiscard]] constexpr T const& front() const { return at(0); }
+    [[nodiscard]] constexpr T& back() { return at(m_size - 1); }
+    [[nodiscard]] constexpr T const& back() const { return at(m_size - 1); }
+
+    // iterators
+    using iterator = lake::contiguous_iterator<T>;
+    using const_iterator = lake::contiguous_iterator<T const>;
+    [[nodiscard]] constexpr iterator begin() { return iterator(data()); }
+    [[nodiscard]] constexpr const_iterator begin() const { return const_iterator(data()); }
+    [[nodiscard]] constexpr iterator end() { return iterator(data() + m_size); }
+    [[nodiscard]] constexpr const_iterator end() const { return const_iterator(data() + m_size); }
+
+    // Appending elements. The try_* variants return false (and leave the vector unchanged) if the vector is full, while
+    // the others require that there is space left.
+    template <typename U>
+    [[nodiscard]] constexpr bool try_push_back(U const& element)
+    {
+        return try_emplace_back(element);
+    }
+    [[nodiscard]] constexpr bool try_push_back(T&& element)
+    {
+        return try_emplace_back(move(element));
+    }
+    template <typename... Args>
+    [[nodiscard]] constexpr bool try_emplace_back(Args&&... args)
+    {
+        if (full()) {
+            return false;
+        }
+        construct_at(m_size, forward<Args>(args)...);
+        ++m_size;
+        return true;
+    }
+
+    template <typename U>
+    constexpr void push_back(U const& element)
+    {
+        emplace_back(element);
+    }
+    constexpr void push_back(T&& element)
+    {
+        emplace_back(move(element));
+    }
+    template <typename... Args>
+    constexpr void emplace_back(Args&&... args)
+    {
+        assert(!full());
+        construct_at(m_size, forward<Args>(args)...);
+        ++m_size;
+    }
+
+    constexpr void pop_back()
+    {
+        assert(m_size >= 1);
+        --m_size;
+        destroy_at(m_size);
+    }
+
+    constexpr void clear()
+    {
+        for (size_t i = 0; i < m_size; ++i) {
+            destroy_at(i);
+        }
+        m_size = 0;
+    }
+
+    template <typename U, size_t OtherCapacity>
+    constexpr bool operator==(static_vector<U, OtherCapacity> const& other) const
+    {
+        return span() == other.span();
+    }
+
+    template <typename U>
+    constexpr bool operator==(::lake::span<U> const& other) const
+    {
+        return span() == other;
+    }
+
+private:
+    template <typename... Args>
+    constexpr void construct_at(size_t index, Args&&... args)
+    {
+        if constexpr (is_trivial) {
+            m_storage.elements[index] = T(forward<Args>(args)...);
+        } else {
+            new (&data()[index]) T(forward<Args>(args)...);
+        }
+    }
+
+    constexpr void destroy_at(size_t index)
+    {
+        if constexpr (!is_trivial) {
+            data()[index].~T();
+        }
+    }
+
+    struct trivial_storage {
+        constexpr T* data() { return elements; }
+        constexpr T const* data() const { return elements; }
+
+        T elements[Capacity] {};
+    };
+
+    struct uninitialized_storage {
+        T* data() { return reinterpret_cast<T*>(&bytes); }
+        T const* data() const { return reinterpret_cast<T const*>(&bytes); }
+
+        alignas(T) u8 bytes[Capacity * sizeof(T)];
+    };
+
+    conditional_t<is_trivial, trivial_storage, uninitialized_storage> m_storage;
+    size_t m_size { 0 };
+};
+
+template <typename T, size_t Capacity>
+struct hash<static_vector<T, Capacity>> {
+    constexpr void operator()(hash_state& h, static_vector<T, Capacity> const& value)
+    {
+        h.hash(value.span());
+    }
+};
+
+}
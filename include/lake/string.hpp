@@ -0,0 +1,275 @@
+/*
+ * SPDX-FileCopyrightText: 2023 Max Wipfli <mail@maxwipfli.ch>
+ * SPDX-LicenseIdentifier: MIT
+ */
+
+#pragma once
+
+#include "allocator.hpp"
+#include "extras.hpp"
+#include "hash.hpp"
+#include "iterator.hpp"
+#include "string_view.hpp"
+#include "type_traits.hpp"
+#include "types.hpp"
+#include <assert.h>
+
+namespace lake {
+
+// An owning, null-terminated string with small-string optimization: Strings of up to 23 characters are stored inside
+// the 24-byte object itself, and only longer ones are allocated from `Alloc`.
+//
+// The two representations share the same bytes:
+//  - inline: the characters and their null terminator, with the last byte holding the number of unused inline
+//    characters. For a string of 23 characters, this byte is zero and doubles as the null terminator.
+//  - heap: data pointer, size and capacity. The most significant bit of the capacity, which is stored in the last byte
+//    on little-endian machines, marks the heap representation.
+template <allocator Alloc = default_allocator>
+class basic_string {
+    static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__, "basic_string requires a little-endian machine");
+
+public:
+    static constexpr size_t inline_capacity = 23;
+
+    basic_string() { set_inline_size(0); }
+
+    explicit basic_string(Alloc allocator)
+        : m_allocator(move(allocator))
+    {
+        set_inline_size(0);
+    }
+
+    // string view (copy) constructor/assignment operator
+    basic_string(string_view view, Alloc allocator = {}) // NOLINT(google-explicit-constructor)
+        : m_allocator(move(allocator))
+    {
+        set_inline_size(0);
+        append(view);
+    }
+    basic_string(char const* cstr, Alloc allocator = {}) // NOLINT(google-explicit-constructor)
+        : basic_string(string_view(cstr), move(allocator))
+    {
+    }
+    basic_string& operator=(string_view view)
+    {
+        // The view may point into this string, so it must not be shortened before the characters are copied.
+        if (view.size() > capacity()) {
+            basic_string tmp(view, m_allocator);
+            *this = move(tmp);
+            return *this;
+        }
+        __builtin_memmove(data(), view.data(), view.size());
+        set_size(view.size());
+        return *this;
+    }
+
+    // copy constructor/assignment operator
+    // NOTE: Copies use the allocator of the string they are copied from.
+    basic_string(basic_string const& other)
+        : basic_string(other.view(), other.m_allocator)
+    {
+    }
+    basic_string& operator=(basic_string const& other)
+    {
+        *this = other.view();
+        return *this;
+    }
+
+    // move constructor/assignment operator
+    // NOTE: These never allocate: Heap storage is taken over from `other`, and inline characters are copied.
+    basic_string(basic_string&& other) noexcept
+        : m_representation(other.m_representation)
+        , m_allocator(move(other.m_allocator))
+    {
+        other.set_inline_size(0);
+    }
+    basic_string& operator=(basic_string&& other) noexcept
+    {
+        if (this == &other) {
+            return *this;
+        }
+        clear();
+        m_representation = other.m_representation;
+        m_allocator = move(other.m_allocator);
+        other.set_inline_size(0);
+        return *this;
+    }
+
+    ~basic_string() { clear(); }
+
+    [[nodiscard]] char* data() { return is_inline() ? m_representation.inline_chars : m_representation.heap.data; }
+    [[nodiscard]] char const* data() const { return is_inline() ? m_representation.inline_chars : m_representation.heap.data; }
+    [[nodiscard]] char const* c_str() const { return data(); }
+    [[nodiscard]] size_t size() const
+    {
+        return is_inline() ? inline_capacity - m_representation.inline_chars[inline_capacity] : m_representation.heap.size;
+    }
+    // The number of characters that fit without reallocating, excluding the null terminator.
+    [[nodiscard]] size_t capacity() const
+    {
+        return is_inline() ? inline_capacity : m_representation.heap.capacity & ~heap_flag;
+    }
+    [[nodiscard]] bool empty() const { return size() == 0; }
+    [[nodiscard]] bool is_inline() const { return !(static_cast<u8>(m_representation.inline_chars[inline_capacity]) & 0x80); }
+    [[nodiscard]] Alloc const& allocator() const { return m_allocator; }
+
+    // views
+    [[nodiscard]] string_view view() const { return { data(), size() }; }
+    [[nodiscard]] operator string_view() const { return view(); } // NOLINT(google-explicit-constructor)
+
+    // element access
+    [[nodiscard]] char& at(size_t index)
+    {
+        assert(index < size());
+        return data()[index];
+    }
+    [[nodiscard]] char const& at(size_t index) const
+    {
+        assert(index < size());
+        return data()[index];
+    }
+    [[nodiscard]] char& operator[](size_t index) { return at(index); }
+    [[nodiscard]] char const& operator[](size_t index) const { return at(index); }
+    [[nodiscard]] char& front() { return at(0); }
+    [[nodiscard]] char const& front() const { return at(0); }
+    [[nodiscard]] char& back() { return at(size() - 1); }
+    [[nodiscard]] char const& back() const { return at(size() - 1); }
+
+    // iterators
+    using iterator = lake::contiguous_iterator<char>;
+    using const_iterator = lake::contiguous_iterator<char const>;
+    [[nodiscard]] iterator begin() { return iterator(data()); }
+    [[nodiscard]] const_iterator begin() const { return const_iterator(data()); }
+    [[nodiscard]] iterator end() { return iterator(data() + size()); }
+    [[nodiscard]] const_iterator end() const { return const_iterator(data() + size()); }
+
+    void append(string_view view)
+    {
+        auto old_size = size();
+        if (old_size + view.size() > capacity()) {
+            // The view may point into this string, which is why this does not use reserve().
+            auto* old_data = data();
+            if (view.data() >= old_data && view.data() < old_data + old_size) {
+                auto offset = view.data() - old_data;
+                reallocate(old_size + view.size());
+                view = { data() + offset, view.size() };
+            } else {
+                reallocate(old_size + view.size());
+            }
+        }
+        __builtin_memcpy(data() + old_size, view.data(), view.size());
+        set_size(old_size + view.size());
+    }
+    void append(char c) { append(string_view(&c, 1)); }
+    void push_back(char c) { append(c); }
+
+    basic_string& operator+=(string_view view)
+    {
+        append(view);
+        return *this;
+    }
+    basic_string& operator+=(char c)
+    {
+        append(c);
+        return *this;
+    }
+
+    void reserve(size_t new_capacity)
+    {
+        if (new_capacity <= capacity())
+            return;
+        reallocate(new_capacity);
+    }
+
+    // Release heap storage, if any, and return to an empty inline string.
+    void clear()
+    {
+        if (!is_inline()) {
+            deallocate_buffer(m_representation.heap.data, capacity());
+        }
+        set_inline_size(0);
+    }
+
+    bool operator==(string_view const& other) const { return view() == other; }
+    bool operator==(char const* other) const { return view() == string_view(other); }
+    template <typename OtherAlloc>
+    bool operator==(basic_string<OtherAlloc> const& other) const
+    {
+        return view() == other.view();
+    }
+
+private:
+    static constexpr size_t heap_flag = 1ull << 63;
+
+    // Buffers hold `capacity` characters and the null terminator.
+    char* allocate_buffer(size_t capacity) { return static_cast<char*>(m_allocator.allocate(capacity + 1, 1)); }
+    void deallocate_buffer(char* buffer, size_t capacity) { m_allocator.deallocate(buffer, capacity + 1, 1); }
+
+    void reallocate(size_t new_capacity)
+    {
+        new_capacity = bit_ceil(new_capacity + 1) - 1;
+        auto current_size = size();
+        char* new_data;
+        if (is_inline()) {
+            new_data = allocate_buffer(new_capacity);
+            __builtin_memcpy(new_data, m_representation.inline_chars, current_size + 1);
+        } else if constexpr (reallocating_allocator<Alloc>) {
+            new_data = static_cast<char*>(m_allocator.reallocate(m_representation.heap.data, capacity() + 1, new_capacity + 1, 1));
+        } else {
+            new_data = allocate_buffer(new_capacity);
+            __builtin_memcpy(new_data, m_representation.heap.data, current_size + 1);
+            deallocate_buffer(m_representation.heap.data, capacity());
+        }
+        m_representation.heap.data = new_data;
+        m_representation.heap.size = current_size;
+        m_representation.heap.capacity = new_capacity | heap_flag;
+    }
+
+    void set_inline_size(size_t size)
+    {
+        assert(size <= inline_capacity);
+        m_representation.inline_chars[size] = '\0';
+        m_representation.inline_chars[inline_capacity] = static_cast<char>(inline_capacity - size);
+    }
+
+    void set_size(size_t size)
+    {
+        if (is_inline()) {
+            set_inline_size(size);
+        } else {
+            m_representation.heap.data[size] = '\0';
+            m_representation.heap.size = size;
+        }
+    }
+
+    union representation {
+        struct {
+            char* data;
+            size_t size;
+            size_t capacity;
+        } heap;
+        char inline_chars[inline_capacity + 1];
+    };
+
+    representation m_representation;
+    [[no_unique_address]] Alloc m_allocator;
+};
+
+using string = basic_string<>;
+
+static_assert(sizeof(string) == 24, "sizeof(string) == 24");
+
+// basic_string does not point into itself (the inline characters are found via `this`), so it can be relocated freely.
+template <typename Alloc>
+struct is_trivially_relocatable<basic_string<Alloc>> : is_trivially_relocatable<Alloc> {
+};
+
+template <typename Alloc>
+struct hash<basic_string<Alloc>> {
+    constexpr void operator()(hash_state& h, basic_string<Alloc> const& value)
+    {
+        h.hash(value.view());
+    }
+};
+
+}
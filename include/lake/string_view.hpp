@@ -7,10 +7,19 @@
 
 #include "array.hpp"
 #include "extras.hpp"
+#include "optional.hpp"
 #include "span.hpp"
 #include "types.hpp"
 #include <assert.h>
 
+#if defined(__AVX2__)
+#    include <immintrin.h>
+#elif defined(__SSSE3__)
+#    include <tmmintrin.h>
+#elif defined(__SSE2__)
+#    include <emmintrin.h>
+#endif
+
 namespace lake {
 
 class string_view : public span<char const> {
@@ -52,23 +61,71 @@ public:
         return { this->data() + start, size };
     }
 
-    // Utility functions
-    [[nodiscard]] constexpr bool contains(string_view const& needle) const
+    // Searching
+    // NOTE: At run time, these scan 16 or 32 bytes at once with SSE2 or AVX2 (if enabled), and the forward search for a
+    //       single character uses memchr(). Without SSSE3, find_first_of() and find_last_not_of() only do so for up to 16
+    //       characters, and test larger sets one byte at a time.
+    [[nodiscard]] optional<size_t> find(char needle) const
     {
-        if (needle.size() > this->size()) {
-            return false;
+        return to_optional(find_byte<false>(this->data(), this->size(), needle));
+    }
+    [[nodiscard]] optional<size_t> find(string_view const& needle) const
+    {
+        return to_optional(find_substring<false>(this->data(), this->size(), needle.data(), needle.size()));
+    }
+    [[nodiscard]] optional<size_t> rfind(char needle) const
+    {
+        return to_optional(find_byte<true>(this->data(), this->size(), needle));
+    }
+    [[nodiscard]] optional<size_t> rfind(string_view const& needle) const
+    {
+        return to_optional(find_substring<true>(this->data(), this->size(), needle.data(), needle.size()));
+    }
+
+    // Find the first character which is contained in `characters`.
+    [[nodiscard]] optional<size_t> find_first_of(string_view const& characters) const
+    {
+        if (characters.size() == 1) {
+            return find(characters[0]);
         }
-        for (size_t i = 0; i < this->size() + 1 - needle.size(); i++) {
-            if (this->subview(i, needle.size()) == needle) {
-                return true;
+        return to_optional(find_of<false, false>(this->data(), this->size(), characters));
+    }
+
+    // Find the last character which is not contained in `characters`.
+    [[nodiscard]] optional<size_t> find_last_not_of(string_view const& characters) const
+    {
+        return to_optional(find_of<true, true>(this->data(), this->size(), characters));
+    }
+
+    [[nodiscard]] constexpr size_t count(char needle) const
+    {
+        return count_byte(this->data(), this->size(), needle);
+    }
+
+    // Count the non-overlapping occurrences of `needle`, which must not be empty.
+    [[nodiscard]] constexpr size_t count(string_view const& needle) const
+    {
+        assert(!needle.empty());
+        size_t count = 0;
+        size_t offset = 0;
+        while (true) {
+            auto index = find_substring<false>(this->data() + offset, this->size() - offset, needle.data(), needle.size());
+            if (index == not_found) {
+                return count;
             }
+            ++count;
+            offset += index + needle.size();
         }
-        return false;
+    }
+
+    [[nodiscard]] constexpr bool contains(string_view const& needle) const
+    {
+        return find_substring<false>(this->data(), this->size(), needle.data(), needle.size()) != not_found;
     }
 
     [[nodiscard]] constexpr bool contains(char needle) const
     {
-        return contains(string_view { &needle, 1 });
+        return find_byte<false>(this->data(), this->size(), needle) != not_found;
     }
 
     [[nodiscard]] constexpr bool starts_with(string_view const& prefix) const
@@ -100,6 +157,331 @@ public:
         }
         return __builtin_memcmp(this->data(), other.data(), this->size()) == 0;
     }
+
+private:
+    // The search functions below return indices, with not_found if there is no match. They all have a scalar
+    // implementation, which is used in constant evaluation and without SIMD support.
+    static constexpr size_t not_found = static_cast<size_t>(-1);
+
+    static optional<size_t> to_optional(size_t index)
+    {
+        if (index == not_found) {
+            return {};
+        }
+        return index;
+    }
+
+    static constexpr bool equal(char const* a, char const* b, size_t size)
+    {
+        if (__builtin_is_constant_evaluated()) {
+            for (size_t i = 0; i < size; ++i) {
+                if (a[i] != b[i]) {
+                    return false;
+                }
+            }
+            return true;
+        }
+        return __builtin_memcmp(a, b, size) == 0;
+    }
+
+    // A set of characters, as a 256-bit bitmap.
+    struct byte_set {
+        constexpr explicit byte_set(string_view const& characters)
+        {
+            for (char c : characters) {
+                auto byte = static_cast<u8>(c);
+                m_bits[byte / 64] |= 1ull << (byte % 64);
+            }
+        }
+
+        [[nodiscard]] constexpr bool contains(char c) const
+        {
+            auto byte = static_cast<u8>(c);
+            return (m_bits[byte / 64] >> (byte % 64)) & 1;
+        }
+
+        u64 m_bits[4] {};
+    };
+
+#if defined(__SSE2__)
+    // A block of bytes, which can be compared against another one all at once. Matches are returned as a bitmask, where
+    // bit i corresponds to the i-th byte in the block.
+    struct byte_block {
+#    if defined(__AVX2__)
+        static constexpr size_t size = 32;
+
+        static byte_block broadcast(char value) { return { _mm256_set1_epi8(value) }; }
+        static byte_block load(char const* data) { return { _mm256_loadu_si256(reinterpret_cast<__m256i const*>(data)) }; }
+
+        [[nodiscard]] u32 match(byte_block other) const
+        {
+            return static_cast<u32>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(m_bytes, other.m_bytes)));
+        }
+
+        static constexpr u32 full_mask = 0xffffffff;
+
+        __m256i m_bytes;
+#    else
+        static constexpr size_t size = 16;
+
+        static byte_block broadcast(char value) { return { _mm_set1_epi8(value) }; }
+        static byte_block load(char const* data) { return { _mm_loadu_si128(reinterpret_cast<__m128i const*>(data)) }; }
+
+        [[nodiscard]] u32 match(byte_block other) const
+        {
+            return static_cast<u32>(_mm_movemask_epi8(_mm_cmpeq_epi8(m_bytes, other.m_bytes)));
+        }
+
+        static constexpr u32 full_mask = 0xffff;
+
+        __m128i m_bytes;
+#    endif
+    };
+
+#    if defined(__SSSE3__)
+    // A set of characters, which a block of bytes can be matched against all at once, after Wojciech Muła's "SIMD-ized
+    // check which bytes are in a set". The set is stored as a 16x16 bitmap, indexed by the low and high nibble of a byte.
+    // Byte shuffles look up the rows for the low nibbles (one table each for high nibbles 0-7 and 8-15) and the bits for
+    // the high nibbles, so sets of any size take the same few instructions.
+    struct block_set {
+        static constexpr bool supports(size_t) { return true; }
+
+        explicit block_set(string_view const& characters)
+        {
+            alignas(16) u8 low_rows[16] {};
+            alignas(16) u8 high_rows[16] {};
+            for (char c : characters) {
+                auto byte = static_cast<u8>(c);
+                (byte < 0x80 ? low_rows : high_rows)[byte & 0x0f] |= static_cast<u8>(1u << ((byte >> 4) & 7));
+            }
+            m_low_rows = load_table(low_rows);
+            m_high_rows = load_table(high_rows);
+        }
+
+        [[nodiscard]] u32 match(byte_block block) const
+        {
+            // Shuffles yield zero for indices with the high bit set, so each table only matches its half of the bytes.
+#        if defined(__AVX2__)
+            auto bytes = block.m_bytes;
+            auto rows = _mm256_or_si256(_mm256_shuffle_epi8(m_low_rows, bytes),
+                _mm256_shuffle_epi8(m_high_rows, _mm256_xor_si256(bytes, _mm256_set1_epi8(static_cast<char>(0x80)))));
+            auto high_nibbles = _mm256_and_si256(_mm256_srli_epi16(bytes, 4), _mm256_set1_epi8(0x0f));
+            auto bit_table = _mm256_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128,
+                1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128);
+            auto bits = _mm256_shuffle_epi8(bit_table, high_nibbles);
+            return static_cast<u32>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_and_si256(rows, bits), bits)));
+#        else
+            auto bytes = block.m_bytes;
+            auto rows = _mm_or_si128(_mm_shuffle_epi8(m_low_rows, bytes),
+                _mm_shuffle_epi8(m_high_rows, _mm_xor_si128(bytes, _mm_set1_epi8(static_cast<char>(0x80)))));
+            auto high_nibbles = _mm_and_si128(_mm_srli_epi16(bytes, 4), _mm_set1_epi8(0x0f));
+            auto bit_table = _mm_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128);
+            auto bits = _mm_shuffle_epi8(bit_table, high_nibbles);
+            return static_cast<u32>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(rows, bits), bits)));
+#        endif
+        }
+
+#        if defined(__AVX2__)
+        static __m256i load_table(u8 const* table)
+        {
+            return _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<__m128i const*>(table)));
+        }
+
+        __m256i m_low_rows;
+        __m256i m_high_rows;
+#        else
+        static __m128i load_table(u8 const* table) { return _mm_load_si128(reinterpret_cast<__m128i const*>(table)); }
+
+        __m128i m_low_rows;
+        __m128i m_high_rows;
+#        endif
+    };
+#    else
+    // A small set of characters, which a block of bytes can be matched against all at once: Every character is compared
+    // against the whole block, and the matches are combined. Larger sets are matched one byte at a time with byte_set.
+    struct block_set {
+        static constexpr size_t max_size = 16;
+
+        static constexpr bool supports(size_t size) { return size <= max_size; }
+
+        explicit block_set(string_view const& characters)
+            : m_size(characters.size())
+        {
+            for (size_t i = 0; i < m_size; ++i) {
+                m_characters[i] = byte_block::broadcast(characters[i]);
+            }
+        }
+
+        [[nodiscard]] u32 match(byte_block block) const
+        {
+            u32 mask = 0;
+            for (size_t i = 0; i < m_size; ++i) {
+                mask |= block.match(m_characters[i]);
+            }
+            return mask;
+        }
+
+        byte_block m_characters[max_size];
+        size_t m_size;
+    };
+#    endif
+
+    // The index of the first (or, if `Reverse`, last) set bit of a non-zero mask.
+    template <bool Reverse>
+    static u32 mask_index(u32 mask)
+    {
+        return Reverse ? 31 - __builtin_clz(mask) : __builtin_ctz(mask);
+    }
+#endif
+
+    template <bool Reverse>
+    static constexpr size_t find_byte_scalar(char const* haystack, size_t begin, size_t end, char needle)
+    {
+        for (size_t n = 0; n < end - begin; ++n) {
+            auto i = Reverse ? end - 1 - n : begin + n;
+            if (haystack[i] == needle) {
+                return i;
+            }
+        }
+        return not_found;
+    }
+
+    template <bool Reverse>
+    static constexpr size_t find_byte(char const* haystack, size_t size, char needle)
+    {
+        if (__builtin_is_constant_evaluated()) {
+            return find_byte_scalar<Reverse>(haystack, 0, size, needle);
+        }
+        if constexpr (!Reverse) {
+            auto const* match = static_cast<char const*>(__builtin_memchr(haystack, needle, size));
+            return match ? static_cast<size_t>(match - haystack) : not_found;
+        }
+#if defined(__SSE2__)
+        auto pattern = byte_block::broadcast(needle);
+        auto end = size;
+        for (; end >= byte_block::size; end -= byte_block::size) {
+            auto start = end - byte_block::size;
+            auto mask = byte_block::load(haystack + start).match(pattern);
+            if (mask != 0) {
+                return start + mask_index<true>(mask);
+            }
+        }
+        return find_byte_scalar<true>(haystack, 0, end, needle);
+#else
+        return find_byte_scalar<true>(haystack, 0, size, needle);
+#endif
+    }
+
+    // Searches [begin, end) for a character which is (or, if `Negate`, is not) contained in `set`.
+    template <bool Reverse, bool Negate>
+    static size_t find_of_scalar(char const* haystack, size_t begin, size_t end, byte_set const& set)
+    {
+        for (size_t n = 0; n < end - begin; ++n) {
+            auto i = Reverse ? end - 1 - n : begin + n;
+            if (set.contains(haystack[i]) != Negate) {
+                return i;
+            }
+        }
+        return not_found;
+    }
+
+    template <bool Reverse, bool Negate>
+    static size_t find_of(char const* haystack, size_t size, string_view const& characters)
+    {
+#if defined(__SSE2__)
+        if (block_set::supports(characters.size())) {
+            block_set set(characters);
+            size_t done = 0;
+            for (; size - done >= byte_block::size; done += byte_block::size) {
+                auto start = Reverse ? size - done - byte_block::size : done;
+                auto mask = set.match(byte_block::load(haystack + start));
+                if (Negate) {
+                    mask = ~mask & byte_block::full_mask;
+                }
+                if (mask != 0) {
+                    return start + mask_index<Reverse>(mask);
+                }
+            }
+            if (Reverse) {
+                return find_of_scalar<true, Negate>(haystack, 0, size - done, byte_set(characters));
+            }
+            return find_of_scalar<false, Negate>(haystack, done, size, byte_set(characters));
+        }
+#endif
+        return find_of_scalar<Reverse, Negate>(haystack, 0, size, byte_set(characters));
+    }
+
+    // Searches the match positions [begin, end).
+    template <bool Reverse>
+    static constexpr size_t find_substring_scalar(char const* haystack, size_t begin, size_t end, char const* needle, size_t needle_size)
+    {
+        for (size_t n = 0; n < end - begin; ++n) {
+            auto i = Reverse ? end - 1 - n : begin + n;
+            if (haystack[i] == needle[0] && equal(haystack + i + 1, needle + 1, needle_size - 1)) {
+                return i;
+            }
+        }
+        return not_found;
+    }
+
+    template <bool Reverse>
+    static constexpr size_t find_substring(char const* haystack, size_t size, char const* needle, size_t needle_size)
+    {
+        if (needle_size > size) {
+            return not_found;
+        }
+        if (needle_size == 0) {
+            return Reverse ? size : 0;
+        }
+        if (needle_size == 1) {
+            return find_byte<Reverse>(haystack, size, needle[0]);
+        }
+        auto positions = size - needle_size + 1;
+#if defined(__SSE2__)
+        if (!__builtin_is_constant_evaluated()) {
+            // Only positions where both the first and the last byte of the needle match are compared in full. This rules
+            // out most positions in ordinary text, a whole block of them at once.
+            auto first = byte_block::broadcast(needle[0]);
+            auto last = byte_block::broadcast(needle[needle_size - 1]);
+            size_t done = 0;
+            for (; positions - done >= byte_block::size; done += byte_block::size) {
+                auto start = Reverse ? positions - done - byte_block::size : done;
+                auto mask = byte_block::load(haystack + start).match(first)
+                    & byte_block::load(haystack + start + needle_size - 1).match(last);
+                while (mask != 0) {
+                    auto index = mask_index<Reverse>(mask);
+                    if (equal(haystack + start + index + 1, needle + 1, needle_size - 2)) {
+                        return start + index;
+                    }
+                    mask &= ~(1u << index);
+                }
+            }
+            if (Reverse) {
+                return find_substring_scalar<true>(haystack, 0, positions - done, needle, needle_size);
+            }
+            return find_substring_scalar<false>(haystack, done, positions, needle, needle_size);
+        }
+#endif
+        return find_substring_scalar<Reverse>(haystack, 0, positions, needle, needle_size);
+    }
+
+    static constexpr size_t count_byte(char const* haystack, size_t size, char needle)
+    {
+        size_t count = 0;
+        size_t i = 0;
+#if defined(__SSE2__)
+        if (!__builtin_is_constant_evaluated()) {
+            auto pattern = byte_block::broadcast(needle);
+            for (; i + byte_block::size <= size; i += byte_block::size) {
+                count += __builtin_popcount(byte_block::load(haystack + i).match(pattern));
+            }
+        }
+#endif
+        for (; i < size; ++i) {
+            count += haystack[i] == needle;
+        }
+        return count;
+    }
 };
 
 }
@@ -0,0 +1,239 @@
+/*
+ * SPDX-FileCopyrightText: 2023 Max Wipfli <mail@maxwipfli.ch>
+ * SPDX-LicenseIdentifier: MIT
+ */
+
+#pragma once
+
+#include "allocator.hpp"
+#include "mutex.hpp"
+#include "types.hpp"
+#include <assert.h>
+#include <pthread.h>
+
+namespace lake {
+
+// A size-class slab allocator with per-thread caches, for containers which are created and destroyed at high rates on
+// many threads.
+//
+// Small allocations (up to max_small_size bytes, with an alignment of at most 16) are rounded up to one of a few dozen
+// size classes. Each thread keeps a cache of free blocks per size class, which serves allocations and deallocations
+// without any synchronization. Blocks move between the thread caches and a global depot in batches, so the depot's locks
+// are only taken once per batch. Blocks may be freed by a different thread than the one which allocated them.
+//
+// Larger or over-aligned allocations are passed on to default_allocator.
+//
+// The allocator is stateless, as deallocate() finds the size class from the size of the allocation.
+//
+// NOTE: Memory for small allocations is taken from the C heap in 64 KiB spans, which are never returned to it.
+//       A thread's cache is returned to the depot when the thread exits.
+struct thread_caching_allocator {
+    static constexpr size_t max_small_size = 32 * 1024;
+    static constexpr size_t max_small_alignment = 16;
+
+    [[nodiscard]] void* allocate(size_t size, size_t alignment)
+    {
+        if (!is_small(size, alignment)) {
+            return default_allocator {}.allocate(size, alignment);
+        }
+        auto& list = local_cache().lists[class_index(size)];
+        if (!list.head) {
+            refill(list, class_index(size));
+        }
+        auto* block = list.head;
+        list.head = block->next;
+        --list.count;
+        return block;
+    }
+
+    void deallocate(void* ptr, size_t size, size_t alignment)
+    {
+        if (!is_small(size, alignment)) {
+            default_allocator {}.deallocate(ptr, size, alignment);
+            return;
+        }
+        auto index = class_index(size);
+        auto& list = local_cache().lists[index];
+        auto* block = static_cast<free_block*>(ptr);
+        block->next = list.head;
+        list.head = block;
+        ++list.count;
+        // Keep up to two batches, so that alternating allocations and deallocations don't go to the depot every time.
+        if (list.count >= 2 * batch_size(index)) {
+            release_batch(list, index);
+        }
+    }
+
+    bool operator==(thread_caching_allocator const&) const { return true; }
+
+    // Size classes: multiples of 16 bytes up to 128 bytes, then four classes per power of two. This wastes at most 25%
+    // of an allocation (and less for small ones).
+    static constexpr size_t class_count = 40;
+
+    static constexpr size_t class_index(size_t size)
+    {
+        if (size <= 128) {
+            return size == 0 ? 0 : (size - 1) / 16;
+        }
+        // 2^k < size <= 2^(k+1), with classes every 2^(k-2) bytes.
+        size_t k = 63 - __builtin_clzll(size - 1);
+        return 8 + (k - 7) * 4 + ((size - 1 - (1ull << k)) >> (k - 2));
+    }
+
+    static constexpr size_t class_size(size_t index)
+    {
+        if (index < 8) {
+            return (index + 1) * 16;
+        }
+        size_t k = (index - 8) / 4 + 7;
+        return (1ull << k) + ((index - 8) % 4 + 1) * (1ull << (k - 2));
+    }
+
+    // The number of blocks moved between a thread cache and the depot at once.
+    static constexpr size_t batch_size(size_t index)
+    {
+        auto count = 8 * 1024 / class_size(index);
+        return count < 2 ? 2 : (count > 64 ? 64 : count);
+    }
+
+private:
+    static constexpr size_t span_size = 64 * 1024;
+
+    static constexpr bool is_small(size_t size, size_t alignment)
+    {
+        return size <= max_small_size && alignment <= max_small_alignment;
+    }
+
+    // Free blocks form singly-linked lists. The first block of a batch in the depot also links to the next batch.
+    struct free_block {
+        free_block* next;
+        free_block* next_batch;
+    };
+
+    struct free_list {
+        free_block* head;
+        size_t count;
+    };
+
+    // Thread caches are trivially destructible, so that they don't depend on C++ runtime support for thread_local
+    // destructors. Instead, a pthread key flushes them when the thread exits.
+    struct thread_cache {
+        free_list lists[class_count];
+        bool registered;
+    };
+
+    // A stack of batches per size class, each on its own cache line.
+    // NOTE: This only exists in static storage, so it is zero-initialized (and unlocked) without an initializer.
+    struct alignas(64) depot_class {
+        spinlock lock;
+        free_block* batches;
+    };
+
+    static inline depot_class s_depot[class_count];
+    static inline pthread_once_t s_key_once = PTHREAD_ONCE_INIT;
+    static inline pthread_key_t s_key;
+
+    static thread_cache& local_cache()
+    {
+        static thread_local thread_cache cache;
+        if (!cache.registered) [[unlikely]] {
+            pthread_once(&s_key_once, [] { pthread_key_create(&s_key, flush_cache); });
+            pthread_setspecific(s_key, &cache);
+            cache.registered = true;
+        }
+        return cache;
+    }
+
+    static void flush_cache(void* ptr)
+    {
+        auto& cache = *static_cast<thread_cache*>(ptr);
+        for (size_t index = 0; index < class_count; ++index) {
+            auto& list = cache.lists[index];
+            while (list.head) {
+                release_batch(list, index);
+            }
+        }
+        // Allocations by later thread exit handlers register the cache again.
+        cache.registered = false;
+    }
+
+    static void push_batch(size_t index, free_block* batch)
+    {
+        auto& depot = s_depot[index];
+        depot.lock.lock();
+        batch->next_batch = depot.batches;
+        depot.batches = batch;
+        depot.lock.unlock();
+    }
+
+    static free_block* pop_batch(size_t index)
+    {
+        auto& depot = s_depot[index];
+        depot.lock.lock();
+        auto* batch = depot.batches;
+        if (batch) {
+            depot.batches = batch->next_batch;
+        }
+        depot.lock.unlock();
+        return batch;
+    }
+
+    // Move up to one batch from the front of `list` to the depot.
+    static void release_batch(free_list& list, size_t index)
+    {
+        auto* first = list.head;
+        auto* last = first;
+        size_t count = 1;
+        while (count < batch_size(index) && last->next) {
+            last = last->next;
+            ++count;
+        }
+        list.head = last->next;
+        list.count -= count;
+        last->next = nullptr;
+        push_batch(index, first);
+    }
+
+    static void refill(free_list& list, size_t index)
+    {
+        auto* batch = pop_batch(index);
+        if (!batch) {
+            batch = carve_span(index);
+        }
+        // Batches flushed at thread exit may be partial, so count the blocks.
+        size_t count = 0;
+        for (auto* block = batch; block; block = block->next) {
+            ++count;
+        }
+        list.head = batch;
+        list.count = count;
+    }
+
+    // Split a new span into batches, and return one of them (keeping the others in the depot).
+    static free_block* carve_span(size_t index)
+    {
+        auto size = class_size(index);
+        auto batch_bytes = batch_size(index) * size;
+        auto* span = static_cast<u8*>(default_allocator {}.allocate(span_size, max_small_alignment));
+        free_block* first_batch = nullptr;
+        for (size_t offset = 0; offset + batch_bytes <= span_size; offset += batch_bytes) {
+            auto* batch = span + offset;
+            for (size_t i = 0; i < batch_size(index); ++i) {
+                auto* block = reinterpret_cast<free_block*>(batch + i * size);
+                block->next = i + 1 < batch_size(index) ? reinterpret_cast<free_block*>(batch + (i + 1) * size) : nullptr;
+            }
+            if (first_batch) {
+                push_batch(index, reinterpret_cast<free_block*>(batch));
+            } else {
+                first_batch = reinterpret_cast<free_block*>(batch);
+            }
+        }
+        return first_batch;
+    }
+};
+
+static_assert(allocator<thread_caching_allocator>);
+static_assert(thread_caching_allocator::class_size(thread_caching_allocator::class_count - 1) == thread_caching_allocator::max_small_size);
+static_assert(thread_caching_allocator::class_index(thread_caching_allocator::max_small_size) == thread_caching_allocator::class_count - 1);
+
+}
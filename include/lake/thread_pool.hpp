@@ -0,0 +1,481 @@
+/*
+ * SPDX-FileCopyrightText: 2023 Max Wipfli <mail@maxwipfli.ch>
+ * SPDX-LicenseIdentifier: MIT
+ */
+
+#pragma once
+
+#include "allocator.hpp"
+#include "atomic.hpp"
+#include "extras.hpp"
+#include "mutex.hpp"
+#include "span.hpp"
+#include "types.hpp"
+#include <assert.h>
+#include <pthread.h>
+#include <unistd.h>
+
+namespace lake {
+
+// A fixed pool of worker threads for fork-join parallelism.
+//
+// Work is expressed with join(a, b), which may run `b` on another thread while the calling one runs `a`. Each worker
+// owns a Chase-Lev deque: join() pushes `b` onto the bottom of the caller's deque and pops it back after running `a`,
+// unless an idle worker has stolen it from the top in the meantime. Recursive joins thus split work in large pieces
+// near the top of the deques, which is where thieves take it from, while each worker processes its own pieces in LIFO
+// (cache-friendly) order. A worker waiting for a stolen job runs other jobs until it completes.
+//
+// Threads which are not workers of the pool (such as the main thread) hand their work to the pool via a shared queue
+// and block until it is done.
+//
+// Idle workers sleep on a futex, and are only woken when there are sleeping workers as new jobs are pushed.
+class thread_pool {
+    struct job;
+    struct worker;
+
+public:
+    explicit thread_pool(size_t thread_count = hardware_concurrency())
+        : m_worker_count(thread_count)
+    {
+        assert(thread_count > 0);
+        m_workers = static_cast<worker*>(default_allocator {}.allocate(thread_count * sizeof(worker), alignof(worker)));
+        for (size_t i = 0; i < thread_count; ++i) {
+            new (&m_workers[i]) worker(this, i);
+        }
+        for (size_t i = 0; i < thread_count; ++i) {
+            [[maybe_unused]] auto result = pthread_create(&m_workers[i].thread, nullptr, worker_main, &m_workers[i]);
+            assert(result == 0);
+        }
+    }
+
+    // NOTE: The pool must not be destroyed while it is still running jobs.
+    ~thread_pool()
+    {
+        m_stopping.store(true, memory_order::seq_cst);
+        m_epoch.fetch_add(1, memory_order::seq_cst);
+        m_epoch.notify_all();
+        for (size_t i = 0; i < m_worker_count; ++i) {
+            pthread_join(m_workers[i].thread, nullptr);
+        }
+        for (size_t i = 0; i < m_worker_count; ++i) {
+            m_workers[i].~worker();
+        }
+        default_allocator {}.deallocate(m_workers, m_worker_count * sizeof(worker), alignof(worker));
+    }
+
+    thread_pool(thread_pool const&) = delete;
+    thread_pool& operator=(thread_pool const&) = delete;
+    thread_pool(thread_pool&&) = delete;
+    thread_pool& operator=(thread_pool&&) = delete;
+
+    // A pool with one worker per online processor, which is created on first use and never destroyed.
+    static thread_pool& global()
+    {
+        pthread_once(&s_global_once, [] {
+            auto* storage = default_allocator {}.allocate(sizeof(thread_pool), alignof(thread_pool));
+            s_global = new (storage) thread_pool();
+        });
+        return *s_global;
+    }
+
+    static size_t hardware_concurrency()
+    {
+        auto count = sysconf(_SC_NPROCESSORS_ONLN);
+        return count > 0 ? static_cast<size_t>(count) : 1;
+    }
+
+    [[nodiscard]] size_t size() const { return m_worker_count; }
+
+    // A grain size which splits `count` elements into a few chunks per worker (for load balancing), but not into chunks
+    // so small that scheduling them costs more than processing them.
+    [[nodiscard]] size_t grain_for(size_t count) const
+    {
+        auto grain = count / (m_worker_count * chunks_per_worker);
+        return grain > min_grain ? grain : min_grain;
+    }
+
+    // Run `fn()` on a worker of this pool and wait for it to finish.
+    template <typename Fn>
+    void run(Fn&& fn)
+    {
+        if (is_worker()) {
+            fn();
+            return;
+        }
+        closure_job<remove_reference_t<Fn>> job(fn);
+        inject(job);
+        job.wait();
+    }
+
+    // Run `a()` and `b()`, potentially in parallel, and return once both have finished.
+    template <typename A, typename B>
+    void join(A&& a, B&& b)
+    {
+        auto* self = s_current_worker;
+        if (!self || self->pool != this) {
+            run([&] { join(a, b); });
+            return;
+        }
+
+        closure_job<remove_reference_t<B>> job_b(b);
+        if (!self->deque.push(&job_b)) {
+            // The deque is full, so there is plenty of work for the other workers already.
+            a();
+            b();
+            return;
+        }
+        notify();
+        a();
+
+        // `job_b` is the last job pushed by this worker, unless it has been stolen. In that case, the job popped instead
+        // (if any) belongs to an enclosing join(), which will find it done.
+        auto* popped = self->deque.pop();
+        if (popped == &job_b) {
+            b();
+            return;
+        }
+        if (popped) {
+            popped->execute();
+        }
+        wait_helping(*self, job_b);
+    }
+
+    // Call `fn(chunk)` for consecutive chunks of `values` of at most `grain` elements each, in parallel.
+    template <typename T, typename Fn>
+    void parallel_for(span<T> values, size_t grain, Fn const& fn)
+    {
+        assert(grain > 0);
+        run([&] { split(values, grain, fn); });
+    }
+
+    // Reduce `values` in parallel: Chunks of at most `grain` elements are mapped to `map(chunk)`, and the results of
+    // neighbouring chunks are combined with `combine(left, right)`. For an empty span, `identity` is returned.
+    //
+    // The order of the chunks is preserved, so `combine` needs to be associative but not commutative.
+    template <typename T, typename R, typename Map, typename Combine>
+    [[nodiscard]] R parallel_reduce(span<T> values, size_t grain, R identity, Map const& map, Combine const& combine)
+    {
+        assert(grain > 0);
+        if (values.size() == 0) {
+            return identity;
+        }
+        R result = identity;
+        run([&] { result = reduce(values, grain, identity, map, combine); });
+        return result;
+    }
+
+private:
+    // Jobs live on the stack of the thread which waits for them. Their state is `pending` until they have been run, and
+    // `waiting` if that thread sleeps on the futex.
+    struct job {
+        enum : u32 {
+            pending = 0,
+            waiting = 1,
+            done = 2,
+        };
+
+        explicit job(void (*function)(job&))
+            : function(function)
+        {
+        }
+
+        void execute()
+        {
+            function(*this);
+            // The waiting thread may return (and destroy the job) as soon as it sees the new state.
+            if (state.exchange(done, memory_order::acq_rel) == waiting) {
+                state.notify_one();
+            }
+        }
+
+        [[nodiscard]] bool is_done() const { return state.load(memory_order::acquire) == done; }
+
+        void wait()
+        {
+            u32 expected = pending;
+            state.compare_exchange_strong(expected, waiting, memory_order::acq_rel, memory_order::acquire);
+            while (!is_done()) {
+                state.wait(waiting);
+            }
+        }
+
+        void (*function)(job&);
+        job* next { nullptr };
+        atomic<u32> state { pending };
+    };
+
+    template <typename Fn>
+    struct closure_job : job {
+        explicit closure_job(Fn& fn)
+            : job(&invoke)
+            , fn(fn)
+        {
+        }
+
+        static void invoke(job& self) { static_cast<closure_job&>(self).fn(); }
+
+        Fn& fn;
+    };
+
+    // The work-stealing deque of Chase and Lev, with the memory orderings of Lê et al. ("Correct and Efficient
+    // Work-Stealing for Weak Memory Models", 2013). Only the owning worker pushes and pops at the bottom, while any
+    // thread may steal from the top.
+    //
+    // The capacity is fixed, as join() runs both sides directly when the deque is full.
+    class work_stealing_deque {
+    public:
+        static constexpr i64 capacity = 1024;
+
+        bool push(job* value)
+        {
+            auto bottom = m_bottom.load(memory_order::relaxed);
+            auto top = m_top.load(memory_order::acquire);
+            if (bottom - top >= capacity) {
+                return false;
+            }
+            m_jobs[bottom & (capacity - 1)].store(value, memory_order::relaxed);
+            atomic_thread_fence(memory_order::release);
+            m_bottom.store(bottom + 1, memory_order::relaxed);
+            return true;
+        }
+
+        job* pop()
+        {
+            auto bottom = m_bottom.load(memory_order::relaxed) - 1;
+            m_bottom.store(bottom, memory_order::relaxed);
+            atomic_thread_fence(memory_order::seq_cst);
+            auto top = m_top.load(memory_order::relaxed);
+            if (top > bottom) {
+                m_bottom.store(bottom + 1, memory_order::relaxed);
+                return nullptr;
+            }
+            auto* value = m_jobs[bottom & (capacity - 1)].load(memory_order::relaxed);
+            if (top == bottom) {
+                // This is the last job, which a thief may be taking at the same time.
+                if (!m_top.compare_exchange_strong(top, top + 1, memory_order::seq_cst, memory_order::relaxed)) {
+                    value = nullptr;
+                }
+                m_bottom.store(bottom + 1, memory_order::relaxed);
+            }
+            return value;
+        }
+
+        job* steal()
+        {
+            auto top = m_top.load(memory_order::acquire);
+            atomic_thread_fence(memory_order::seq_cst);
+            auto bottom = m_bottom.load(memory_order::acquire);
+            if (top >= bottom) {
+                return nullptr;
+            }
+            auto* value = m_jobs[top & (capacity - 1)].load(memory_order::relaxed);
+            if (!m_top.compare_exchange_strong(top, top + 1, memory_order::seq_cst, memory_order::relaxed)) {
+                // Lost the race against the owner or another thief.
+                return nullptr;
+            }
+            return value;
+        }
+
+    private:
+        // The ends are on separate cache lines, as they are written by different threads.
+        alignas(64) atomic<i64> m_top { 0 };
+        alignas(64) atomic<i64> m_bottom { 0 };
+        atomic<job*> m_jobs[capacity];
+    };
+
+    struct alignas(64) worker {
+        worker(thread_pool* pool, size_t index)
+            : pool(pool)
+            , random_state(index * 0x9e3779b97f4a7c15ull + 1)
+        {
+        }
+
+        work_stealing_deque deque;
+        thread_pool* pool;
+        pthread_t thread {};
+        u64 random_state;
+    };
+
+    static void* worker_main(void* argument)
+    {
+        auto& self = *static_cast<worker*>(argument);
+        s_current_worker = &self;
+        self.pool->work(self);
+        s_current_worker = nullptr;
+        return nullptr;
+    }
+
+    void work(worker& self)
+    {
+        while (true) {
+            if (auto* job = find_job(self)) {
+                job->execute();
+                continue;
+            }
+
+            // Register as a sleeper before looking for jobs once more: Threads which push jobs after that will see the
+            // sleeper and bump the epoch, so the futex wait below returns immediately.
+            auto epoch = m_epoch.load(memory_order::seq_cst);
+            m_sleepers.fetch_add(1, memory_order::seq_cst);
+            auto* job = find_job(self);
+            if (!job && !m_stopping.load(memory_order::seq_cst)) {
+                m_epoch.wait(epoch);
+            }
+            m_sleepers.fetch_sub(1, memory_order::seq_cst);
+            if (job) {
+                job->execute();
+            } else if (m_stopping.load(memory_order::seq_cst)) {
+                return;
+            }
+        }
+    }
+
+    // Look for a job in the worker's own deque, then in those of the other workers (starting at a random one), and
+    // finally in the queue of jobs from outside the pool.
+    job* find_job(worker& self)
+    {
+        if (auto* job = self.deque.pop()) {
+            return job;
+        }
+        if (m_worker_count > 1) {
+            self.random_state ^= self.random_state << 13;
+            self.random_state ^= self.random_state >> 7;
+            self.random_state ^= self.random_state << 17;
+            auto start = self.random_state % m_worker_count;
+            for (size_t i = 0; i < m_worker_count; ++i) {
+                auto& victim = m_workers[(start + i) % m_worker_count];
+                if (&victim == &self) {
+                    continue;
+                }
+                if (auto* job = victim.deque.steal()) {
+                    return job;
+                }
+            }
+        }
+        return take_injected();
+    }
+
+    // Wait for a stolen job to finish, running other jobs in the meantime. Without any, the worker spins for a while
+    // and then sleeps until the job is done.
+    void wait_helping(worker& self, job& stolen)
+    {
+        size_t idle_rounds = 0;
+        while (!stolen.is_done()) {
+            if (auto* job = find_job(self)) {
+                job->execute();
+                idle_rounds = 0;
+                continue;
+            }
+            if (++idle_rounds > max_idle_rounds) {
+                stolen.wait();
+                return;
+            }
+            cpu_relax();
+        }
+    }
+
+    // Wake a sleeping worker, if any, after a job has been pushed.
+    void notify()
+    {
+        atomic_thread_fence(memory_order::seq_cst);
+        if (m_sleepers.load(memory_order::seq_cst) > 0) {
+            m_epoch.fetch_add(1, memory_order::seq_cst);
+            m_epoch.notify_one();
+        }
+    }
+
+    void inject(job& job)
+    {
+        {
+            lock_guard guard(m_injected_lock);
+            if (m_injected_tail) {
+                m_injected_tail->next = &job;
+            } else {
+                m_injected_head = &job;
+            }
+            m_injected_tail = &job;
+            m_has_injected.store(true, memory_order::relaxed);
+        }
+        notify();
+    }
+
+    job* take_injected()
+    {
+        if (!m_has_injected.load(memory_order::acquire)) {
+            return nullptr;
+        }
+        lock_guard guard(m_injected_lock);
+        auto* job = m_injected_head;
+        if (job) {
+            m_injected_head = job->next;
+            if (!m_injected_head) {
+                m_injected_tail = nullptr;
+                m_has_injected.store(false, memory_order::relaxed);
+            }
+        }
+        return job;
+    }
+
+    [[nodiscard]] bool is_worker() const { return s_current_worker && s_current_worker->pool == this; }
+
+    template <typename T, typename Fn>
+    void split(span<T> values, size_t grain, Fn const& fn)
+    {
+        if (values.size() <= grain) {
+            fn(values);
+            return;
+        }
+        auto half = values.size() / 2;
+        join([&] { split(values.subspan(0, half), grain, fn); },
+            [&] { split(values.subspan(half, values.size() - half), grain, fn); });
+    }
+
+    template <typename T, typename R, typename Map, typename Combine>
+    R reduce(span<T> values, size_t grain, R const& identity, Map const& map, Combine const& combine)
+    {
+        if (values.size() <= grain) {
+            return map(values);
+        }
+        auto half = values.size() / 2;
+        R left = identity;
+        R right = identity;
+        join([&] { left = reduce(values.subspan(0, half), grain, identity, map, combine); },
+            [&] { right = reduce(values.subspan(half, values.size() - half), grain, identity, map, combine); });
+        return combine(move(left), move(right));
+    }
+
+    static constexpr size_t max_idle_rounds = 1024;
+    static constexpr size_t chunks_per_worker = 8;
+    static constexpr size_t min_grain = 1024;
+
+    // NOTE: These don't depend on C++ runtime support for thread_local destructors or guarded static initialization.
+    static inline thread_local worker* s_current_worker = nullptr;
+    static inline pthread_once_t s_global_once = PTHREAD_ONCE_INIT;
+    static inline thread_pool* s_global = nullptr;
+
+    worker* m_workers { nullptr };
+    size_t m_worker_count { 0 };
+    atomic<bool> m_stopping { false };
+    atomic<bool> m_has_injected { false };
+    mutex m_injected_lock;
+    job* m_injected_head { nullptr };
+    job* m_injected_tail { nullptr };
+    alignas(64) atomic<u32> m_epoch { 0 };
+    atomic<u32> m_sleepers { 0 };
+};
+
+// Run `fn(chunk)` for consecutive chunks of `values` of at most `grain` elements each, on the global thread pool.
+template <typename T, typename Fn>
+void parallel_for(span<T> values, size_t grain, Fn const& fn)
+{
+    thread_pool::global().parallel_for(values, grain, fn);
+}
+
+// Reduce `values` on the global thread pool, see thread_pool::parallel_reduce().
+template <typename T, typename R, typename Map, typename Combine>
+[[nodiscard]] R parallel_reduce(span<T> values, size_t grain, R identity, Map const& map, Combine const& combine)
+{
+    return thread_pool::global().parallel_reduce(values, grain, move(identity), map, combine);
+}
+
+}
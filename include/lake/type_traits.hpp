@@ -7,6 +7,118 @@
 
 namespace lake {
 
+// integral_constant
+template <typename T, T v>
+struct integral_constant {
+    static constexpr T value = v;
+};
+
+template <bool v>
+using bool_constant = integral_constant<bool, v>;
+using true_type = bool_constant<true>;
+using false_type = bool_constant<false>;
+
+// is_same
+template <typename T, typename U>
+struct is_same : false_type {
+};
+template <typename T>
+struct is_same<T, T> : true_type {
+};
+
+template <typename T, typename U>
+inline constexpr bool is_same_v = is_same<T, U>::value;
+
+template <typename T, typename U>
+concept same_as = is_same_v<T, U> && is_same_v<U, T>;
+
+// convertible_to (implicitly)
+template <typename From, typename To>
+concept convertible_to = requires(void (*accept)(To), From from) { accept(from); };
+
+// conditional
+template <bool B, typename T, typename F>
+struct conditional {
+    using type = T;
+};
+template <typename T, typename F>
+struct conditional<false, T, F> {
+    using type = F;
+};
+
+template <bool B, typename T, typename F>
+using conditional_t = typename conditional<B, T, F>::type;
+
+// is_integral (including bool and character types)
+template <typename T>
+struct is_integral : false_type {
+};
+template <typename T>
+struct is_integral<T const> : is_integral<T> {
+};
+#define LAKE_DEFINE_INTEGRAL(type)         \
+    template <>                            \
+    struct is_integral<type> : true_type { \
+    };
+LAKE_DEFINE_INTEGRAL(bool)
+LAKE_DEFINE_INTEGRAL(char)
+LAKE_DEFINE_INTEGRAL(signed char)
+LAKE_DEFINE_INTEGRAL(unsigned char)
+LAKE_DEFINE_INTEGRAL(wchar_t)
+LAKE_DEFINE_INTEGRAL(char8_t)
+LAKE_DEFINE_INTEGRAL(char16_t)
+LAKE_DEFINE_INTEGRAL(char32_t)
+LAKE_DEFINE_INTEGRAL(short)
+LAKE_DEFINE_INTEGRAL(unsigned short)
+LAKE_DEFINE_INTEGRAL(int)
+LAKE_DEFINE_INTEGRAL(unsigned int)
+LAKE_DEFINE_INTEGRAL(long)
+LAKE_DEFINE_INTEGRAL(unsigned long)
+LAKE_DEFINE_INTEGRAL(long long)
+LAKE_DEFINE_INTEGRAL(unsigned long long)
+#undef LAKE_DEFINE_INTEGRAL
+
+template <typename T>
+inline constexpr bool is_integral_v = is_integral<T>::value;
+
+// is_floating_point
+template <typename T>
+struct is_floating_point : false_type {
+};
+template <typename T>
+struct is_floating_point<T const> : is_floating_point<T> {
+};
+template <>
+struct is_floating_point<float> : true_type {
+};
+template <>
+struct is_floating_point<double> : true_type {
+};
+template <>
+struct is_floating_point<long double> : true_type {
+};
+
+template <typename T>
+inline constexpr bool is_floating_point_v = is_floating_point<T>::value;
+
+// is_arithmetic
+template <typename T>
+inline constexpr bool is_arithmetic_v = is_integral_v<T> || is_floating_point_v<T>;
+
+// is_pointer
+template <typename T>
+struct is_pointer : false_type {
+};
+template <typename T>
+struct is_pointer<T*> : true_type {
+};
+template <typename T>
+struct is_pointer<T* const> : true_type {
+};
+
+template <typename T>
+inline constexpr bool is_pointer_v = is_pointer<T>::value;
+
 // remove_const
 template <typename T>
 struct remove_const {
@@ -37,4 +149,19 @@ struct remove_reference<T&&> {
 template <typename T>
 using remove_reference_t = typename remove_reference<T>::type;
 
+// remove_cvref (only const, as volatile is not used)
+template <typename T>
+using remove_cvref_t = remove_const_t<remove_reference_t<T>>;
+
+// is_trivially_relocatable
+// A type is trivially relocatable if moving an object to a new location and destroying the old one is equivalent to
+// copying its bytes. This is true for all trivially copyable types, and can be opted into for other types (e.g. owning
+// pointers) by specializing this struct.
+template <typename T>
+struct is_trivially_relocatable : bool_constant<__is_trivially_copyable(T)> {
+};
+
+template <typename T>
+inline constexpr bool is_trivially_relocatable_v = is_trivially_relocatable<T>::value;
+
 }
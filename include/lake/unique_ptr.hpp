@@ -5,20 +5,37 @@
 
 #pragma once
 
+#include "allocator.hpp"
 #include "extras.hpp"
+#include "type_traits.hpp"
 
 namespace lake {
 
-template <typename T>
+// NOTE: Objects owned through the default allocator are created with `new` and destroyed with `delete`, so that
+//       pointers obtained from `new` can be adopted. With any other allocator, the object's memory is obtained from
+//       (and returned to) that allocator.
+template <typename T, allocator Alloc = default_allocator>
 class unique_ptr {
 public:
-    static unique_ptr<T> adopt(T* ptr)
+    static unique_ptr adopt(T* ptr, Alloc allocator = {})
+    {
+        return unique_ptr(ptr, move(allocator));
+    }
+
+    template <typename... Args>
+    static unique_ptr create(Alloc allocator, Args&&... args)
     {
-        return unique_ptr<T>(ptr);
+        T* ptr = construct(allocator, forward<Args>(args)...);
+        return unique_ptr(ptr, move(allocator));
     }
 
     unique_ptr() = default;
 
+    explicit unique_ptr(Alloc allocator)
+        : m_allocator(move(allocator))
+    {
+    }
+
     ~unique_ptr()
     {
         clear();
@@ -28,6 +45,7 @@ public:
 
     unique_ptr(unique_ptr&& other) noexcept
         : m_ptr(other.m_ptr)
+        , m_allocator(move(other.m_allocator))
     {
         other.m_ptr = nullptr;
     }
@@ -38,12 +56,14 @@ public:
     {
         clear();
         m_ptr = other.m_ptr;
+        m_allocator = move(other.m_allocator);
         other.m_ptr = nullptr;
         return *this;
     }
 
     T* ptr() { return m_ptr; }
     T const* ptr() const { return m_ptr; }
+    Alloc const& allocator() const { return m_allocator; }
 
     T* operator*() { return m_ptr; }
     T const* operator*() const { return m_ptr; }
@@ -53,25 +73,51 @@ public:
     operator bool() const { return m_ptr; } // NOLINT(google-explicit-constructor)
 
     template <typename... Args>
-    void emplace(Args... args)
+    void emplace(Args&&... args)
     {
         clear();
-        m_ptr = new T(args...);
+        m_ptr = construct(m_allocator, forward<Args>(args)...);
     }
 
     void clear()
     {
-        delete m_ptr;
+        if (!m_ptr) {
+            return;
+        }
+        if constexpr (is_same_v<Alloc, default_allocator>) {
+            delete m_ptr;
+        } else {
+            m_ptr->~T();
+            m_allocator.deallocate(m_ptr, sizeof(T), alignof(T));
+        }
         m_ptr = nullptr;
     }
 
 private:
-    explicit unique_ptr(T* ptr)
+    unique_ptr(T* ptr, Alloc allocator)
         : m_ptr(ptr)
+        , m_allocator(move(allocator))
     {
     }
 
+    template <typename... Args>
+    static T* construct(Alloc& allocator, Args&&... args)
+    {
+        if constexpr (is_same_v<Alloc, default_allocator>) {
+            return new T(forward<Args>(args)...);
+        } else {
+            auto* slot = allocator.allocate(sizeof(T), alignof(T));
+            return new (slot) T(forward<Args>(args)...);
+        }
+    }
+
     T* m_ptr { nullptr };
+    [[no_unique_address]] Alloc m_allocator;
+};
+
+// Moving a unique_ptr just transfers the pointer (and the allocator), so it can be relocated by copying its bytes.
+template <typename T, typename Alloc>
+struct is_trivially_relocatable<unique_ptr<T, Alloc>> : is_trivially_relocatable<Alloc> {
 };
 
 template <typename T>
@@ -81,10 +127,16 @@ unique_ptr<T> adopt_unique(T* ptr)
 }
 
 template <typename T, typename... Args>
-unique_ptr<T> make_unique(Args... args)
+unique_ptr<T> make_unique(Args&&... args)
 {
-    T* ptr = new T(args...);
+    T* ptr = new T(forward<Args>(args)...);
     return unique_ptr<T>::adopt(ptr);
 }
 
+template <typename T, typename Alloc, typename... Args>
+unique_ptr<T, Alloc> allocate_unique(Alloc allocator, Args&&... args)
+{
+    return unique_ptr<T, Alloc>::create(move(allocator), forward<Args>(args)...);
+}
+
 }
@@ -5,24 +5,32 @@
 
 #pragma once
 
+#include "allocator.hpp"
 #include "extras.hpp"
+#include "hash.hpp"
 #include "iterator.hpp"
 #include "span.hpp"
+#include "type_traits.hpp"
 #include "types.hpp"
 #include <assert.h>
 #include <initializer_list>
-#include <stdlib.h>
 
 namespace lake {
 
-template <typename T>
+template <typename T, allocator Alloc = default_allocator>
 class vector {
 public:
     vector() = default;
 
+    explicit vector(Alloc allocator)
+        : m_allocator(move(allocator))
+    {
+    }
+
     // span (copy) constructor/assignment operators
     template <typename U>
-    vector(lake::span<U> span) // NOLINT(google-explicit-constructor)
+    vector(lake::span<U> span, Alloc allocator = {}) // NOLINT(google-explicit-constructor)
+        : m_allocator(move(allocator))
     {
         m_capacity = good_capacity(span.size());
         m_data = allocate_buffer(m_capacity);
@@ -33,7 +41,7 @@ public:
         }
     }
     template <typename U>
-    vector<T>& operator=(lake::span<U> span)
+    vector& operator=(lake::span<U> span)
     {
         if (span.size() > m_capacity) {
             // Clear the old allocation, and reallocate from a blank slate.
@@ -46,15 +54,19 @@ public:
             }
         } else {
             // Reuse the current allocation.
-            assert(m_size <= span.size());
-            // Use move assignment operator for all objects that already exist.
-            for (size_t i = 0; i < m_size; ++i) {
+            auto common_size = m_size < span.size() ? m_size : span.size();
+            // Use copy assignment operator for all objects that already exist.
+            for (size_t i = 0; i < common_size; ++i) {
                 m_data[i] = span[i];
             }
-            // Use move constructor for all "new" objects.
-            for (size_t i = m_size; i < span.size(); ++i) {
+            // Use copy constructor for all "new" objects.
+            for (size_t i = common_size; i < span.size(); ++i) {
                 new (&m_data[i]) T(span[i]);
             }
+            // Destroy all objects beyond the new size.
+            for (size_t i = common_size; i < m_size; ++i) {
+                m_data[i].~T();
+            }
             m_size = span.size();
         }
         return *this;
@@ -62,53 +74,57 @@ public:
 
     // initializer list constructor/assignment operators (via span)
     template <typename U>
-    vector(std::initializer_list<U> initializer_list)
-        : vector(lake::span<U const>(data(initializer_list), initializer_list.size()))
+    vector(std::initializer_list<U> initializer_list, Alloc allocator = {})
+        : vector(lake::span<U const>(initializer_list), move(allocator))
     {
     }
     template <typename U>
-    vector<T>& operator=(std::initializer_list<U> initializer_list)
+    vector& operator=(std::initializer_list<U> initializer_list)
     {
-        *this = lake::span<U const>(data(initializer_list), initializer_list.size());
+        *this = lake::span<U const>(initializer_list);
         return *this;
     }
 
     // copy constructor/assignment operator
-    template <typename U>
-    explicit vector(vector<U> const& other)
-        : vector(other.span())
+    // NOTE: Copies use the allocator of the vector they are copied from.
+    template <typename U, typename OtherAlloc>
+    explicit vector(vector<U, OtherAlloc> const& other)
+        : vector(other.span(), other.allocator())
     {
     }
-    template <typename U>
-    vector<T>& operator=(vector<U> const& other)
+    template <typename U, typename OtherAlloc>
+    vector& operator=(vector<U, OtherAlloc> const& other)
     {
         *this = other.span();
         return *this;
     }
 
     // move constructor/assignment operator
-    vector(vector<T>&& other) noexcept
+    vector(vector&& other) noexcept
         : m_data(other.m_data)
         , m_capacity(other.m_capacity)
         , m_size(other.m_size)
+        , m_allocator(move(other.m_allocator))
     {
         other.m_data = nullptr;
         other.m_capacity = 0;
         other.m_size = 0;
     }
-    vector<T>& operator=(vector<T>&& other) noexcept
+    vector& operator=(vector&& other) noexcept
     {
         clear();
         m_data = exchange(other.m_data, nullptr);
         m_capacity = exchange(other.m_capacity, 0);
         m_size = exchange(other.m_size, 0);
+        m_allocator = move(other.m_allocator);
+        return *this;
     }
 
     ~vector() { clear(); }
 
-    static vector<T> filled(size_t count, T const& value)
+    static vector filled(size_t count, T const& value, Alloc allocator = {})
     {
-        vector<T> vec;
+        vector vec(move(allocator));
         vec.reserve(count);
         for (size_t i = 0; i < count; ++i) {
             vec.push_back(value);
@@ -121,6 +137,7 @@ public:
     [[nodiscard]] size_t capacity() const { return m_capacity; }
     [[nodiscard]] size_t size() const { return m_size; }
     [[nodiscard]] bool empty() const { return m_size == 0; }
+    [[nodiscard]] Alloc const& allocator() const { return m_allocator; }
 
     // spans
     [[nodiscard]] ::lake::span<T> span() { return { m_data, m_size }; }
@@ -172,7 +189,7 @@ public:
     }
 
     template <typename... Args>
-    void emplace_back(Args... args)
+    void emplace_back(Args&&... args)
     {
         reserve(m_size + 1);
         new (&m_data[m_size]) T(forward<Args>(args)...);
@@ -186,11 +203,88 @@ public:
         m_data[m_size].~T();
     }
 
+    // Append copies of all elements of `span`, which may also point into this vector.
+    template <typename U>
+    void append(lake::span<U> span)
+    {
+        if constexpr (is_same_v<remove_const_t<U>, T>) {
+            if (span.size() > m_capacity - m_size && span.data() >= m_data && span.data() < m_data + m_size) {
+                // The elements are moved by the reallocation, so find them again afterwards.
+                auto offset = span.data() - m_data;
+                reserve(m_size + span.size());
+                span = { m_data + offset, span.size() };
+            }
+        }
+        reserve(m_size + span.size());
+        copy_construct(m_data + m_size, span);
+        m_size += span.size();
+    }
+
+    // Insert copies of all elements of `span` before the element at `index` (or at the end, if `index == size()`).
+    // NOTE: `span` must not point into this vector.
+    template <typename U>
+    void insert(size_t index, lake::span<U> span)
+    {
+        assert(index <= m_size);
+        reserve(m_size + span.size());
+        relocate(m_data + index + span.size(), m_data + index, m_size - index);
+        copy_construct(m_data + index, span);
+        m_size += span.size();
+    }
+
+    // Remove the elements in the range [first, last), moving the following elements forward.
+    void erase(size_t first, size_t last)
+    {
+        assert(first <= last && last <= m_size);
+        for (size_t i = first; i < last; ++i) {
+            m_data[i].~T();
+        }
+        relocate(m_data + first, m_data + last, m_size - last);
+        m_size -= last - first;
+    }
+
+    // Change the number of elements, either by value-initializing new elements (e.g. with zero) or by destroying the
+    // elements at the end.
+    void resize(size_t new_size)
+    {
+        reserve(new_size);
+        for (size_t i = m_size; i < new_size; ++i) {
+            new (&m_data[i]) T();
+        }
+        set_size(new_size);
+    }
+
+    // Like resize(), but new elements are default-initialized, which leaves trivial types (e.g. integers) uninitialized.
+    // Use this if the new elements are overwritten right away, e.g. when reading into the vector.
+    void resize_for_overwrite(size_t new_size)
+    {
+        reserve(new_size);
+        for (size_t i = m_size; i < new_size; ++i) {
+            new (&m_data[i]) T;
+        }
+        set_size(new_size);
+    }
+
     void reserve(size_t new_capacity)
     {
         if (new_capacity <= m_capacity)
             return;
-        reallocate(new_capacity);
+        reallocate(good_capacity(new_capacity));
+    }
+
+    // Reduce the capacity to the current size, releasing unused memory.
+    void shrink_to_fit()
+    {
+        if (m_capacity == m_size) {
+            return;
+        }
+        if (m_size == 0) {
+            deallocate_buffer(m_data, m_capacity);
+            m_data = nullptr;
+            m_capacity = 0;
+            return;
+        }
+        reallocate(m_size);
     }
 
     void clear()
@@ -203,21 +297,22 @@ public:
             elem.~T();
         }
 
-        free(m_data);
+        deallocate_buffer(m_data, m_capacity);
         m_data = nullptr;
         m_capacity = 0;
         m_size = 0;
     }
 
-    void swap(vector<T>& other)
+    void swap(vector& other)
     {
         ::lake::swap(m_data, other.m_data);
         ::lake::swap(m_capacity, other.m_capacity);
         ::lake::swap(m_size, other.m_size);
+        ::lake::swap(m_allocator, other.m_allocator);
     }
 
-    template <typename U>
-    bool operator==(vector<U> const& other) const
+    template <typename U, typename OtherAlloc>
+    bool operator==(vector<U, OtherAlloc> const& other) const
     {
         return span() == other;
     }
@@ -237,30 +332,102 @@ private:
     }
 
     // Assumes that `capacity` is already a good capacity.
-    static T* allocate_buffer(size_t capacity)
+    T* allocate_buffer(size_t capacity)
     {
-        auto* ptr = calloc(capacity, sizeof(T));
-        assert(ptr != nullptr);
-        return static_cast<T*>(ptr);
+        return static_cast<T*>(m_allocator.allocate(capacity * sizeof(T), alignof(T)));
     }
 
+    void deallocate_buffer(T* buffer, size_t capacity)
+    {
+        m_allocator.deallocate(buffer, capacity * sizeof(T), alignof(T));
+    }
+
+    // Change the capacity to exactly `new_capacity`, which must hold all elements.
     void reallocate(size_t new_capacity)
     {
         assert(m_size <= new_capacity);
-        m_capacity = good_capacity(new_capacity);
+        auto old_capacity = exchange(m_capacity, new_capacity);
+        if constexpr (is_trivially_relocatable_v<T> && reallocating_allocator<Alloc>) {
+            if (m_data) {
+                // The elements can be relocated by copying their bytes, which the allocator does for us (possibly
+                // without copying anything at all, if the allocation can be grown in place).
+                auto* ptr = m_allocator.reallocate(m_data, old_capacity * sizeof(T), m_capacity * sizeof(T), alignof(T));
+                m_data = static_cast<T*>(ptr);
+                return;
+            }
+        }
         auto* new_data = allocate_buffer(m_capacity);
-        for (size_t i = 0; i < m_size; ++i) {
-            // Move into new buffer.
-            new (&new_data[i]) T(move(m_data[i]));
-            // Destroy old object.
-            m_data[i].~T();
+        if (m_data) {
+            relocate(new_data, m_data, m_size);
+            deallocate_buffer(m_data, old_capacity);
         }
-        free(m_data);
         m_data = new_data;
     }
 
+    // Move `count` elements from `source` to the uninitialized part of `destination`, and destroy them in `source`. The
+    // ranges may overlap (e.g. when shifting elements within the buffer).
+    static void relocate(T* destination, T* source, size_t count)
+    {
+        if (count == 0 || destination == source) {
+            return;
+        }
+        if constexpr (is_trivially_relocatable_v<T>) {
+            // Relocate all elements at once by copying their bytes.
+            __builtin_memmove(static_cast<void*>(destination), source, count * sizeof(T));
+        } else if (destination < source) {
+            for (size_t i = 0; i < count; ++i) {
+                new (&destination[i]) T(move(source[i]));
+                source[i].~T();
+            }
+        } else {
+            for (size_t i = count; i-- > 0;) {
+                new (&destination[i]) T(move(source[i]));
+                source[i].~T();
+            }
+        }
+    }
+
+    // Copy the elements of `source` into the uninitialized `destination`.
+    template <typename U>
+    static void copy_construct(T* destination, lake::span<U> source)
+    {
+        if constexpr (is_same_v<remove_const_t<U>, T> && __is_trivially_copyable(T)) {
+            if (!source.empty()) {
+                __builtin_memcpy(static_cast<void*>(destination), source.data(), source.size() * sizeof(T));
+            }
+        } else {
+            for (size_t i = 0; i < source.size(); ++i) {
+                new (&destination[i]) T(source[i]);
+            }
+        }
+    }
+
+    // Set the size to `new_size`, destroying all elements beyond it. All elements below it must already exist.
+    void set_size(size_t new_size)
+    {
+        for (size_t i = new_size; i < m_size; ++i) {
+            m_data[i].~T();
+        }
+        m_size = new_size;
+    }
+
     T* m_data { nullptr };
     size_t m_capacity { 0 };
     size_t m_size { 0 };
+    [[no_unique_address]] Alloc m_allocator;
 };
+
+// vector only holds a pointer to its heap buffer (and its allocator), so it can be relocated freely.
+template <typename T, typename Alloc>
+struct is_trivially_relocatable<vector<T, Alloc>> : is_trivially_relocatable<Alloc> {
+};
+
+template <typename T, typename Alloc>
+struct hash<vector<T, Alloc>> {
+    constexpr void operator()(hash_state& h, vector<T, Alloc> const& value)
+    {
+        h.hash(value.span());
+    }
+};
+
 }
@@ -0,0 +1,157 @@
+/*
+ * SPDX-FileCopyrightText: 2023 Max Wipfli <mail@maxwipfli.ch>
+ * SPDX-LicenseIdentifier: MIT
+ */
+
+#include "utils.hpp"
+#include <algorithm>
+#include <gtest/gtest.h>
+#include <lake/algorithm.hpp>
+#include <lake/string.hpp>
+#include <lake/unique_ptr.hpp>
+#include <lake/vector.hpp>
+
+// A simple, deterministic pseudo-random number generator (xorshift).
+static lake::vector<i64> make_input(size_t size, int pattern, u64 seed)
+{
+    lake::vector<i64> values;
+    for (size_t i = 0; i < size; ++i) {
+        auto n = static_cast<i64>(i);
+        auto size_n = static_cast<i64>(size);
+        switch (pattern) {
+        case 0: // random
+            values.push_back(static_cast<i64>(next_random(seed)));
+            break;
+        case 1: // sorted
+            values.push_back(n);
+            break;
+        case 2: // reverse sorted
+            values.push_back(size_n - n);
+            break;
+        case 3: // all equal
+            values.push_back(42);
+            break;
+        case 4: // few distinct values
+            values.push_back(static_cast<i64>(next_random(seed) % 4));
+            break;
+        case 5: // organ pipe
+            values.push_back(n < size_n / 2 ? n : size_n - n);
+            break;
+        case 6: // sorted, with a few random elements
+            values.push_back(i % 64 == 0 ? static_cast<i64>(next_random(seed) % size) : n);
+            break;
+        default: // sawtooth
+            values.push_back(n % 100);
+            break;
+        }
+    }
+    return values;
+}
+
+TEST(Sort, Patterns)
+{
+    for (size_t size : { 0, 1, 2, 3, 10, 23, 24, 25, 100, 129, 1000, 12345, 100000 }) {
+        for (int pattern = 0; pattern < 8; ++pattern) {
+            auto values = make_input(size, pattern, size + 1);
+            auto expected = make_input(size, pattern, size + 1);
+            std::sort(expected.begin(), expected.end());
+
+            lake::sort(values.span());
+            ASSERT_EQ(values, expected) << "size " << size << ", pattern " << pattern;
+        }
+    }
+}
+
+TEST(Sort, Comparator)
+{
+    auto values = make_input(10000, 0, 1);
+    lake::sort(values.span(), [](i64 a, i64 b) { return a > b; });
+    EXPECT_TRUE(lake::is_sorted(values.span(), [](i64 a, i64 b) { return a > b; }));
+    EXPECT_FALSE(lake::is_sorted(values.span()));
+
+    // Sorting by a key only.
+    lake::vector<u32> keys;
+    u64 seed = 7;
+    for (size_t i = 0; i < 5000; ++i) {
+        keys.push_back(static_cast<u32>(next_random(seed)));
+    }
+    lake::sort(keys.span(), [](u32 a, u32 b) { return (a & 0xff) < (b & 0xff); });
+    for (size_t i = 1; i < keys.size(); ++i) {
+        ASSERT_LE(keys[i - 1] & 0xff, keys[i] & 0xff);
+    }
+}
+
+TEST(Sort, FloatingPoint)
+{
+    lake::vector<double> values;
+    u64 seed = 3;
+    for (size_t i = 0; i < 1000; ++i) {
+        values.push_back(static_cast<double>(static_cast<i64>(next_random(seed))) / 1e9);
+    }
+    lake::sort(values.span());
+    EXPECT_TRUE(lake::is_sorted(values.span()));
+}
+
+static bool lexicographically_less(lake::string const& a, lake::string const& b)
+{
+    auto common = a.size() < b.size() ? a.size() : b.size();
+    auto result = __builtin_memcmp(a.data(), b.data(), common);
+    return result < 0 || (result == 0 && a.size() < b.size());
+}
+
+TEST(Sort, Strings)
+{
+    lake::vector<lake::string> values;
+    u64 seed = 5;
+    for (size_t i = 0; i < 2000; ++i) {
+        lake::string str = i % 2 ? "a string which does not fit inline " : "";
+        auto number = next_random(seed) % 1000;
+        str.append(static_cast<char>('0' + number / 100));
+        str.append(static_cast<char>('0' + number / 10 % 10));
+        str.append(static_cast<char>('0' + number % 10));
+        values.push_back(lake::move(str));
+    }
+    lake::sort(values.span(), lexicographically_less);
+    for (size_t i = 1; i < values.size(); ++i) {
+        ASSERT_FALSE(lexicographically_less(values[i], values[i - 1]));
+    }
+}
+
+TEST(Sort, MoveOnly)
+{
+    int destruction_count = 0;
+    {
+        lake::vector<lake::unique_ptr<int>> values;
+        for (int i = 0; i < 1000; ++i) {
+            values.push_back(lake::make_unique<int>((i * 7919) % 1000));
+        }
+        lake::sort(values.span(), [](auto const& a, auto const& b) { return *a.ptr() < *b.ptr(); });
+        for (int i = 0; i < 1000; ++i) {
+            ASSERT_EQ(*values[i].ptr(), i);
+        }
+
+        lake::vector<lake::unique_ptr<destruction_counter>> counters;
+        for (int i = 0; i < 100; ++i) {
+            counters.push_back(lake::make_unique<destruction_counter>(&destruction_count));
+        }
+        lake::sort(counters.span(), [](auto const& a, auto const& b) { return a.ptr() < b.ptr(); });
+        // Sorting only moves the elements.
+        EXPECT_EQ(destruction_count, 0);
+    }
+    EXPECT_EQ(destruction_count, 100);
+}
+
+TEST(Sort, LinearOnSortedInput)
+{
+    // Sorted and reverse sorted inputs are detected, which needs only a linear number of comparisons.
+    for (int pattern : { 1, 2, 3 }) {
+        auto values = make_input(100000, pattern, 1);
+        size_t comparisons = 0;
+        lake::sort(values.span(), [&](i64 a, i64 b) {
+            ++comparisons;
+            return a < b;
+        });
+        EXPECT_TRUE(lake::is_sorted(values.span()));
+        EXPECT_LT(comparisons, 4 * values.size()) << "pattern " << pattern;
+    }
+}
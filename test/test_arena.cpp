@@ -0,0 +1,111 @@
+/*
+ * SPDX-FileCopyrightText: 2023 Max Wipfli <mail@maxwipfli.ch>
+ * SPDX-LicenseIdentifier: MIT
+ */
+
+#include "utils.hpp"
+#include <gtest/gtest.h>
+#include <lake/arena.hpp>
+#include <lake/fixed_array.hpp>
+#include <lake/vector.hpp>
+
+TEST(Arena, Empty)
+{
+    lake::arena arena;
+    EXPECT_EQ(arena.bytes_used(), 0);
+    EXPECT_EQ(arena.peak_bytes_used(), 0);
+    // The arena must not allocate until it is used.
+    EXPECT_EQ(arena.bytes_reserved(), 0);
+}
+
+TEST(Arena, Alignment)
+{
+    lake::arena arena;
+    (void)arena.allocate(1, 1);
+    for (size_t alignment = 1; alignment <= 4096; alignment *= 2) {
+        auto* ptr = arena.allocate(3, alignment);
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(ptr) % alignment, 0);
+    }
+}
+
+TEST(Arena, ManyAllocations)
+{
+    lake::arena arena(4096);
+    for (size_t i = 0; i < 10000; ++i) {
+        auto* ptr = static_cast<u64*>(arena.allocate(sizeof(u64), alignof(u64)));
+        *ptr = i;
+    }
+    EXPECT_EQ(arena.bytes_used(), 10000 * sizeof(u64));
+    EXPECT_GE(arena.bytes_reserved(), arena.bytes_used());
+}
+
+TEST(Arena, LargeAllocation)
+{
+    lake::arena arena(4096);
+    auto* small = arena.allocate(16, 16);
+    auto* large = arena.allocate(1024 * 1024, 64);
+    auto* next = arena.allocate(16, 16);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(large) % 64, 0);
+    // The remainder of the current chunk is still used after a large allocation.
+    EXPECT_EQ(static_cast<u8*>(small) + 16, next);
+    __builtin_memset(large, 0xab, 1024 * 1024);
+}
+
+TEST(Arena, PeakAndReset)
+{
+    lake::arena arena;
+    (void)arena.allocate(100, 1);
+    (void)arena.allocate(200, 1);
+    EXPECT_EQ(arena.bytes_used(), 300);
+
+    arena.reset();
+    EXPECT_EQ(arena.bytes_used(), 0);
+    EXPECT_EQ(arena.peak_bytes_used(), 300);
+    // The current chunk is kept for reuse.
+    EXPECT_EQ(arena.bytes_reserved(), lake::arena::default_chunk_size);
+
+    (void)arena.allocate(50, 1);
+    EXPECT_EQ(arena.bytes_used(), 50);
+    EXPECT_EQ(arena.peak_bytes_used(), 300);
+}
+
+TEST(Arena, RollbackLastAllocation)
+{
+    lake::arena arena;
+    auto* first = arena.allocate(32, 8);
+    arena.deallocate(first, 32, 8);
+    EXPECT_EQ(arena.bytes_used(), 0);
+    auto* second = arena.allocate(32, 8);
+    EXPECT_EQ(first, second);
+}
+
+TEST(Arena, Containers)
+{
+    lake::arena arena;
+    {
+        lake::vector<u32, lake::arena_allocator> vec(lake::arena_allocator { arena });
+        for (u32 i = 0; i < 1000; ++i) {
+            vec.push_back(i);
+        }
+        for (u32 i = 0; i < 1000; ++i) {
+            EXPECT_EQ(vec[i], i);
+        }
+        // The vector is the only user of the arena, so it could be grown in place.
+        EXPECT_EQ(arena.bytes_used(), vec.capacity() * sizeof(u32));
+
+        lake::fixed_array<int, lake::arena_allocator> fa({ 1, 2, 3 }, lake::arena_allocator(arena));
+        EXPECT_EQ(fa.size(), 3);
+        EXPECT_EQ(fa[2], 3);
+    }
+    EXPECT_EQ(arena.bytes_used(), 0);
+    EXPECT_GE(arena.peak_bytes_used(), 1000 * sizeof(u32));
+
+    int destruction_count = 0;
+    {
+        lake::vector<destruction_counter, lake::arena_allocator> vec(lake::arena_allocator { arena });
+        for (int i = 0; i < 100; ++i) {
+            vec.emplace_back(&destruction_count);
+        }
+    }
+    EXPECT_EQ(destruction_count, 100);
+}
@@ -0,0 +1,116 @@
+/*
+ * SPDX-FileCopyrightText: 2023 Max Wipfli <mail@maxwipfli.ch>
+ * SPDX-LicenseIdentifier: MIT
+ */
+
+#include <gtest/gtest.h>
+#include <lake/atomic.hpp>
+#include <pthread.h>
+
+using lake::memory_order;
+
+TEST(Atomic, LoadStoreExchange)
+{
+    lake::atomic<u64> value;
+    EXPECT_EQ(value.load(memory_order::relaxed), 0);
+    value.store(42, memory_order::release);
+    EXPECT_EQ(value.load(memory_order::acquire), 42);
+    EXPECT_EQ(value.exchange(7, memory_order::acq_rel), 42);
+    EXPECT_EQ(value.load(memory_order::seq_cst), 7);
+}
+
+TEST(Atomic, CompareExchange)
+{
+    lake::atomic<int> value { 5 };
+    int expected = 4;
+    EXPECT_FALSE(value.compare_exchange_strong(expected, 10, memory_order::acq_rel, memory_order::acquire));
+    EXPECT_EQ(expected, 5);
+    EXPECT_TRUE(value.compare_exchange_strong(expected, 10, memory_order::acq_rel, memory_order::acquire));
+    EXPECT_EQ(value.load(memory_order::relaxed), 10);
+
+    expected = 10;
+    while (!value.compare_exchange_weak(expected, 11, memory_order::relaxed, memory_order::relaxed)) {
+    }
+    EXPECT_EQ(value.load(memory_order::relaxed), 11);
+}
+
+TEST(Atomic, Arithmetic)
+{
+    lake::atomic<u32> value { 0b1100 };
+    EXPECT_EQ(value.fetch_add(3, memory_order::relaxed), 0b1100);
+    EXPECT_EQ(value.fetch_sub(1, memory_order::relaxed), 0b1111);
+    EXPECT_EQ(value.fetch_and(0b0110, memory_order::relaxed), 0b1110);
+    EXPECT_EQ(value.fetch_or(0b1000, memory_order::relaxed), 0b0110);
+    EXPECT_EQ(value.fetch_xor(0b1111, memory_order::relaxed), 0b1110);
+    EXPECT_EQ(value.load(memory_order::relaxed), 0b0001);
+}
+
+TEST(Atomic, Pointer)
+{
+    u64 values[4] = {};
+    lake::atomic<u64*> pointer { values };
+    // Pointer arithmetic is in elements.
+    EXPECT_EQ(pointer.fetch_add(3, memory_order::relaxed), values);
+    EXPECT_EQ(pointer.load(memory_order::relaxed), values + 3);
+    EXPECT_EQ(pointer.fetch_sub(1, memory_order::relaxed), values + 3);
+    EXPECT_EQ(pointer.load(memory_order::relaxed), values + 2);
+}
+
+TEST(Atomic, TriviallyCopyable)
+{
+    struct pair {
+        u32 first;
+        u32 second;
+
+        bool operator==(pair const&) const = default;
+    };
+    lake::atomic<pair> value { pair { 1, 2 } };
+    pair expected { 1, 2 };
+    EXPECT_TRUE(value.compare_exchange_strong(expected, pair { 3, 4 }, memory_order::acq_rel, memory_order::acquire));
+    EXPECT_EQ(value.load(memory_order::acquire), (pair { 3, 4 }));
+}
+
+static void* increment(void* argument)
+{
+    auto& counter = *static_cast<lake::atomic<u64>*>(argument);
+    for (size_t i = 0; i < 100000; ++i) {
+        counter.fetch_add(1, memory_order::relaxed);
+    }
+    return nullptr;
+}
+
+TEST(Atomic, Threads)
+{
+    lake::atomic<u64> counter;
+    pthread_t threads[4];
+    for (auto& thread : threads) {
+        pthread_create(&thread, nullptr, increment, &counter);
+    }
+    for (auto& thread : threads) {
+        pthread_join(thread, nullptr);
+    }
+    EXPECT_EQ(counter.load(memory_order::relaxed), 400000);
+}
+
+static void* set_and_notify(void* argument)
+{
+    auto& value = *static_cast<lake::atomic<u32>*>(argument);
+    value.store(1, memory_order::release);
+    value.notify_all();
+    return nullptr;
+}
+
+TEST(Atomic, WaitNotify)
+{
+    lake::atomic<u32> value { 0 };
+    // The value is not 1, so this returns immediately.
+    value.wait(1);
+
+    pthread_t thread;
+    pthread_create(&thread, nullptr, set_and_notify, &value);
+    while (value.load(memory_order::acquire) == 0) {
+        value.wait(0);
+    }
+    pthread_join(thread, nullptr);
+    EXPECT_EQ(value.load(memory_order::relaxed), 1);
+}
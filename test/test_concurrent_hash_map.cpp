@@ -0,0 +1,140 @@
+/*
+ * SPDX-FileCopyrightText: 2023 Max Wipfli <mail@maxwipfli.ch>
+ * SPDX-LicenseIdentifier: MIT
+ */
+
+#include <gtest/gtest.h>
+#include <lake/concurrent_hash_map.hpp>
+#include <lake/string.hpp>
+#include <pthread.h>
+
+TEST(ConcurrentHashMap, FindInsertRemove)
+{
+    lake::concurrent_hash_map<u64, u64> map;
+    EXPECT_EQ(map.shard_count(), 64);
+    EXPECT_TRUE(map.empty());
+    EXPECT_FALSE(map.find(1).has_value());
+
+    for (u64 i = 0; i < 1000; ++i) {
+        EXPECT_TRUE(map.insert(i, i * 2));
+    }
+    EXPECT_FALSE(map.insert(5, 0));
+    EXPECT_EQ(map.size(), 1000);
+    for (u64 i = 0; i < 1000; ++i) {
+        auto value = map.find(i);
+        ASSERT_TRUE(value.has_value());
+        EXPECT_EQ(value.value(), i * 2);
+    }
+
+    EXPECT_FALSE(map.insert_or_assign(5, 42));
+    EXPECT_EQ(map.find(5).value(), 42);
+    EXPECT_TRUE(map.insert_or_assign(1000, 1));
+    EXPECT_TRUE(map.contains(1000));
+
+    EXPECT_TRUE(map.remove(5));
+    EXPECT_FALSE(map.remove(5));
+    EXPECT_FALSE(map.contains(5));
+    EXPECT_EQ(map.size(), 1000);
+
+    map.clear();
+    EXPECT_TRUE(map.empty());
+}
+
+TEST(ConcurrentHashMap, Upsert)
+{
+    lake::concurrent_hash_map<lake::string, int> map(3);
+    EXPECT_EQ(map.shard_count(), 4);
+    EXPECT_TRUE(map.upsert("a", [](int& count) { ++count; }));
+    EXPECT_FALSE(map.upsert("a", [](int& count) { ++count; }));
+    EXPECT_TRUE(map.upsert("b", [](int& count) { count += 10; }));
+    EXPECT_EQ(map.find("a").value(), 2);
+    EXPECT_EQ(map.find("b").value(), 10);
+}
+
+TEST(ConcurrentHashMap, SingleShard)
+{
+    lake::concurrent_hash_map<u64, u64> map(1);
+    for (u64 i = 0; i < 100; ++i) {
+        map.insert_or_assign(i, i);
+    }
+    EXPECT_EQ(map.size(), 100);
+    EXPECT_EQ(map.find(99).value(), 99);
+}
+
+// A key which counts how often it is hashed.
+struct counted_key {
+    static inline size_t hash_count = 0;
+
+    u64 value;
+
+    bool operator==(counted_key const&) const = default;
+};
+
+template <>
+struct lake::hash<counted_key> {
+    void operator()(hash_state& h, counted_key const& key)
+    {
+        ++counted_key::hash_count;
+        h.hash(key.value);
+    }
+};
+
+TEST(ConcurrentHashMap, HashesKeysOnce)
+{
+    lake::concurrent_hash_map<counted_key, u64> map;
+    auto hashes = [](auto const& operation) {
+        auto before = counted_key::hash_count;
+        operation();
+        return counted_key::hash_count - before;
+    };
+    EXPECT_EQ(hashes([&] { map.upsert(counted_key { 1 }, [](u64& value) { value = 10; }); }), 1);
+    EXPECT_EQ(hashes([&] { map.upsert(counted_key { 1 }, [](u64& value) { ++value; }); }), 1);
+    EXPECT_EQ(hashes([&] { EXPECT_EQ(map.find(counted_key { 1 }).value(), 11); }), 1);
+    EXPECT_EQ(hashes([&] { EXPECT_TRUE(map.contains(counted_key { 1 })); }), 1);
+    EXPECT_EQ(hashes([&] { map.insert(counted_key { 2 }, 2); }), 1);
+    EXPECT_EQ(hashes([&] { map.insert_or_assign(counted_key { 2 }, 3); }), 1);
+    EXPECT_EQ(hashes([&] { map.remove(counted_key { 2 }); }), 1);
+}
+
+static constexpr size_t thread_count = 4;
+static constexpr u64 keys_per_thread = 5000;
+
+struct shared_map {
+    lake::concurrent_hash_map<u64, u64> map { 8 };
+    size_t next_thread { 0 };
+};
+
+// Every thread counts all keys (so they contend on the same entries), and inserts and reads back keys of its own.
+static void* count_and_insert(void* argument)
+{
+    auto& shared = *static_cast<shared_map*>(argument);
+    auto thread = __atomic_fetch_add(&shared.next_thread, 1, __ATOMIC_RELAXED);
+    for (u64 i = 0; i < keys_per_thread; ++i) {
+        shared.map.upsert(i, [](u64& count) { ++count; });
+        auto own_key = (thread + 1) * 1000000 + i;
+        shared.map.insert_or_assign(own_key, i);
+        auto value = shared.map.find(own_key);
+        if (!value.has_value() || value.value() != i) {
+            return argument;
+        }
+    }
+    return nullptr;
+}
+
+TEST(ConcurrentHashMap, Threads)
+{
+    shared_map shared;
+    pthread_t threads[thread_count];
+    for (auto& thread : threads) {
+        pthread_create(&thread, nullptr, count_and_insert, &shared);
+    }
+    for (auto& thread : threads) {
+        void* result;
+        pthread_join(thread, &result);
+        EXPECT_EQ(result, nullptr);
+    }
+    EXPECT_EQ(shared.map.size(), keys_per_thread * (thread_count + 1));
+    for (u64 i = 0; i < keys_per_thread; ++i) {
+        ASSERT_EQ(shared.map.find(i).value(), thread_count);
+    }
+}
@@ -45,4 +45,21 @@ TEST(FixedArray, DestructionCounts)
     EXPECT_EQ(destruction_count, 2);
 }
 
+TEST(FixedArray, Allocator)
+{
+    counting_allocator::stats stats;
+    {
+        lake::fixed_array<int, counting_allocator> fa({ 1, 2, 3 }, counting_allocator(&stats));
+        EXPECT_EQ(stats.allocations, 1);
+        EXPECT_EQ(fa.size(), 3);
+        EXPECT_EQ(fa[2], 3);
+
+        auto copy = fa;
+        EXPECT_EQ(stats.allocations, 2);
+        EXPECT_EQ(copy, fa);
+    }
+    EXPECT_EQ(stats.allocations, 0);
+    EXPECT_EQ(stats.bytes, 0);
+}
+
 // TODO: Add some more tests, similar to test_vector.
@@ -5,7 +5,12 @@
 
 #include "utils.hpp"
 #include <gtest/gtest.h>
+#include <lake/array.hpp>
+#include <lake/fixed_array.hpp>
 #include <lake/hash.hpp>
+#include <lake/static_vector.hpp>
+#include <lake/string_view.hpp>
+#include <lake/vector.hpp>
 
 TEST(Hash, HashState)
 {
@@ -36,3 +41,223 @@ TEST(Hash, NoCollision)
 
     EXPECT_NE(hs1.value(), hs2.value());
 }
+
+static u64 hash_of(u64 value)
+{
+    lake::hash_state hs;
+    hs.hash(value);
+    return hs.value();
+}
+
+TEST(Hash, Constexpr)
+{
+    constexpr auto value = [] {
+        lake::hash_state hs;
+        hs.hash((u64)42);
+        return hs.value();
+    }();
+    static_assert(value != lake::hash_state().value());
+    EXPECT_EQ(value, hash_of(42));
+}
+
+TEST(Hash, OrderDependent)
+{
+    lake::hash_state hs1;
+    hs1.hash(1);
+    hs1.hash(2);
+
+    lake::hash_state hs2;
+    hs2.hash(2);
+    hs2.hash(1);
+
+    EXPECT_NE(hs1.value(), hs2.value());
+}
+
+TEST(Hash, EarlyInputsAreKept)
+{
+    // Inputs combined first must still affect the result after many more inputs.
+    lake::hash_state hs1;
+    lake::hash_state hs2;
+    hs1.hash(1);
+    hs2.hash(2);
+    for (int i = 0; i < 1000; ++i) {
+        hs1.hash(0);
+        hs2.hash(0);
+    }
+    EXPECT_NE(hs1.value(), hs2.value());
+}
+
+TEST(Hash, EarlyInputsAreKeptAfterSecret)
+{
+    // The multiplication in combine_with() has a zero operand for this input, which must not erase the earlier ones.
+    constexpr u64 secret = 0x8bb84b93962eacc9ull;
+    auto hash_pair = [](u64 first, u64 second) {
+        lake::hash_state hs;
+        hs.hash(first);
+        hs.hash(second);
+        return hs.value();
+    };
+    EXPECT_NE(hash_pair(1, secret), hash_pair(2, secret));
+    EXPECT_NE(hash_pair(1, secret), hash_pair(12345, secret));
+    EXPECT_NE(hash_pair(2, secret), hash_pair(12345, secret));
+    EXPECT_NE(hash_pair(0, secret), hash_pair(1ull << 63, secret));
+}
+
+TEST(Hash, Avalanche)
+{
+    // Flipping any single input bit should flip every output bit with a probability of about 1/2.
+    constexpr size_t samples = 2000;
+    static u32 flips[64][64] = {};
+    u64 input = 0x0123456789abcdefull;
+    for (size_t sample = 0; sample < samples; ++sample) {
+        // Use a simple LCG to generate inputs.
+        input = input * 6364136223846793005ull + 1442695040888963407ull;
+        auto hash = hash_of(input);
+        for (size_t in_bit = 0; in_bit < 64; ++in_bit) {
+            auto diff = hash ^ hash_of(input ^ (1ull << in_bit));
+            for (size_t out_bit = 0; out_bit < 64; ++out_bit) {
+                flips[in_bit][out_bit] += (diff >> out_bit) & 1;
+            }
+        }
+    }
+    for (size_t in_bit = 0; in_bit < 64; ++in_bit) {
+        for (size_t out_bit = 0; out_bit < 64; ++out_bit) {
+            auto probability = static_cast<double>(flips[in_bit][out_bit]) / samples;
+            EXPECT_GT(probability, 0.4) << "input bit " << in_bit << ", output bit " << out_bit;
+            EXPECT_LT(probability, 0.6) << "input bit " << in_bit << ", output bit " << out_bit;
+        }
+    }
+}
+
+TEST(Hash, Distribution)
+{
+    // Sequential and composite keys must spread evenly over buckets selected by the low bits and by the high bits.
+    constexpr size_t bucket_count = 1024;
+    constexpr size_t key_count = 64 * bucket_count;
+    static u32 low_buckets[bucket_count];
+    static u32 high_buckets[bucket_count];
+    static u32 composite_buckets[bucket_count];
+
+    for (u64 i = 0; i < key_count; ++i) {
+        auto hash = hash_of(i);
+        low_buckets[hash % bucket_count]++;
+        high_buckets[hash >> 54]++;
+
+        lake::hash_state hs;
+        hs.hash((u32)(i / 256));
+        hs.hash((u32)(i % 256));
+        composite_buckets[hs.value() % bucket_count]++;
+    }
+
+    // With 64 keys per bucket on average, the standard deviation is about 8, so allow for 6 standard deviations.
+    for (auto* buckets : { low_buckets, high_buckets, composite_buckets }) {
+        for (size_t i = 0; i < bucket_count; ++i) {
+            EXPECT_GT(buckets[i], 64 - 48);
+            EXPECT_LT(buckets[i], 64 + 48);
+        }
+    }
+}
+
+template <typename T>
+static constexpr u64 hash_of_value(T const& value)
+{
+    lake::hash_state hs;
+    hs.hash(value);
+    return hs.value();
+}
+
+// Hashes the first `size` bytes of a fixed pseudo-random pattern. This is evaluated both at compile time (which uses the
+// scalar code) and at run time (which uses SIMD for long inputs, if available).
+static constexpr u64 hash_of_pattern(size_t size)
+{
+    lake::array<char, 4096> bytes {};
+    u64 state = 0x0123456789abcdefull;
+    for (auto& byte : bytes) {
+        state = state * 6364136223846793005ull + 1442695040888963407ull;
+        byte = static_cast<char>(state >> 56);
+    }
+    return hash_of_value(bytes.subspan(0, size));
+}
+
+TEST(Hash, StringView)
+{
+    constexpr auto value = hash_of_value(lake::string_view("hello"));
+    static_assert(value != hash_of_value(lake::string_view("hellp")));
+    static_assert(value != hash_of_value(lake::string_view("hell")));
+    static_assert(hash_of_value(lake::string_view("")) != lake::hash_state().value());
+    EXPECT_EQ(value, hash_of_value(lake::string_view("hello")));
+}
+
+TEST(Hash, BytesConstexprMatchesRuntime)
+{
+    // Cover all code paths: short inputs, medium inputs with and without the 48-byte loop, and long inputs with and
+    // without full blocks.
+    constexpr u64 expected[] = {
+        hash_of_pattern(0), hash_of_pattern(1), hash_of_pattern(3), hash_of_pattern(4), hash_of_pattern(8),
+        hash_of_pattern(16), hash_of_pattern(17), hash_of_pattern(48), hash_of_pattern(49), hash_of_pattern(512),
+        hash_of_pattern(513), hash_of_pattern(1024), hash_of_pattern(1025), hash_of_pattern(4096)
+    };
+    size_t const sizes[] = { 0, 1, 3, 4, 8, 16, 17, 48, 49, 512, 513, 1024, 1025, 4096 };
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i) {
+        EXPECT_EQ(hash_of_pattern(sizes[i]), expected[i]) << "size " << sizes[i];
+    }
+}
+
+TEST(Hash, BytesSensitivity)
+{
+    // Every prefix of the input hashes differently.
+    lake::vector<u64> hashes;
+    for (size_t size = 0; size <= 2100; ++size) {
+        hashes.push_back(hash_of_pattern(size));
+    }
+    for (size_t i = 0; i < hashes.size(); ++i) {
+        for (size_t j = i + 1; j < hashes.size(); ++j) {
+            EXPECT_NE(hashes[i], hashes[j]) << "sizes " << i << " and " << j;
+        }
+    }
+
+    // Flipping any single bit of the input changes the hash, for all input sizes.
+    for (size_t size : { 1, 7, 16, 40, 100, 512, 700, 2100 }) {
+        auto bytes = lake::vector<char>::filled(size, 'x');
+        auto expected = hash_of_value(bytes.span());
+        for (size_t i = 0; i < size; ++i) {
+            for (int bit = 0; bit < 8; ++bit) {
+                bytes[i] ^= static_cast<char>(1 << bit);
+                EXPECT_NE(hash_of_value(bytes.span()), expected) << "size " << size << ", byte " << i << ", bit " << bit;
+                bytes[i] ^= static_cast<char>(1 << bit);
+            }
+        }
+    }
+}
+
+TEST(Hash, Containers)
+{
+    // All contiguous containers hash like a span of their elements.
+    lake::array<u32, 4> array { 1, 2, 3, 4 };
+    auto expected = hash_of_value(array.span());
+    EXPECT_NE(expected, hash_of_value(array.subspan(0, 3)));
+
+    EXPECT_EQ(hash_of_value(array), expected);
+    EXPECT_EQ(hash_of_value(static_cast<lake::array<u32, 4> const&>(array).span()), expected);
+    EXPECT_EQ(hash_of_value(lake::vector<u32>(array.span())), expected);
+    EXPECT_EQ(hash_of_value(lake::fixed_array<u32>(array.span())), expected);
+    EXPECT_EQ(hash_of_value(lake::static_vector<u32, 8>(array.span())), expected);
+}
+
+TEST(Hash, ContainersOfNonTrivialElements)
+{
+    // Elements which are not trivially hashable are hashed one by one, so the hash depends on their contents only.
+    auto make_vector = [](lake::string_view first, lake::string_view second) {
+        lake::vector<lake::string_view> vec;
+        vec.push_back(first);
+        vec.push_back(second);
+        return vec;
+    };
+    char hello[] = "hello";
+    auto expected = hash_of_value(make_vector("hello", "world"));
+    EXPECT_EQ(hash_of_value(make_vector(hello, "world")), expected);
+    EXPECT_NE(hash_of_value(make_vector("hello", "world!")), expected);
+
+    // Moving the boundary between elements changes the hash.
+    EXPECT_NE(hash_of_value(make_vector("hellow", "orld")), expected);
+}
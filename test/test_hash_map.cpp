@@ -0,0 +1,146 @@
+/*
+ * SPDX-FileCopyrightText: 2023 Max Wipfli <mail@maxwipfli.ch>
+ * SPDX-LicenseIdentifier: MIT
+ */
+
+#include "utils.hpp"
+#include <gtest/gtest.h>
+#include <lake/hash_map.hpp>
+#include <lake/unique_ptr.hpp>
+
+TEST(HashMap, Empty)
+{
+    lake::hash_map<u64, u64> map;
+    EXPECT_EQ(map.size(), 0);
+    EXPECT_TRUE(map.empty());
+    // The default constructor must not allocate.
+    EXPECT_EQ(map.capacity(), 0);
+    EXPECT_EQ(map.find(42), nullptr);
+    EXPECT_FALSE(map.remove(42));
+    EXPECT_EQ(map.begin(), map.end());
+}
+
+TEST(HashMap, Basic)
+{
+    lake::hash_map<u64, int> map;
+    EXPECT_TRUE(map.insert(1, 10));
+    EXPECT_TRUE(map.insert(2, 20));
+    EXPECT_FALSE(map.insert(1, 11));
+    EXPECT_EQ(map.size(), 2);
+    EXPECT_EQ(*map.find(1), 10);
+    EXPECT_EQ(*map.find(2), 20);
+    EXPECT_FALSE(map.contains(3));
+
+    EXPECT_FALSE(map.insert_or_assign(1, 12));
+    EXPECT_EQ(*map.find(1), 12);
+    EXPECT_TRUE(map.insert_or_assign(3, 30));
+    EXPECT_EQ(*map.find(3), 30);
+
+    EXPECT_TRUE(map.remove(2));
+    EXPECT_FALSE(map.remove(2));
+    EXPECT_FALSE(map.contains(2));
+    EXPECT_EQ(map.size(), 2);
+}
+
+TEST(HashMap, ManyKeys)
+{
+    constexpr u64 count = 100000;
+    lake::hash_map<u64, u64> map;
+    for (u64 i = 0; i < count; ++i) {
+        EXPECT_TRUE(map.insert(i, i * 3));
+    }
+    EXPECT_EQ(map.size(), count);
+    // The load factor must stay below 7/8.
+    EXPECT_LE(map.size(), map.capacity() - map.capacity() / 8);
+    for (u64 i = 0; i < count; ++i) {
+        auto* value = map.find(i);
+        ASSERT_NE(value, nullptr);
+        EXPECT_EQ(*value, i * 3);
+    }
+    EXPECT_EQ(map.find(count), nullptr);
+
+    for (u64 i = 0; i < count; i += 2) {
+        EXPECT_TRUE(map.remove(i));
+    }
+    EXPECT_EQ(map.size(), count / 2);
+    for (u64 i = 0; i < count; ++i) {
+        EXPECT_EQ(map.contains(i), i % 2 == 1);
+    }
+}
+
+TEST(HashMap, Churn)
+{
+    // Repeatedly inserting and removing keys must not grow the table, as tombstones are cleaned up by rehashing.
+    lake::hash_map<u64, u64> map;
+    for (u64 i = 0; i < 64; ++i) {
+        map.insert(i, i);
+    }
+    auto capacity = map.capacity();
+    for (u64 i = 64; i < 100000; ++i) {
+        EXPECT_TRUE(map.remove(i - 64));
+        EXPECT_TRUE(map.insert(i, i));
+    }
+    EXPECT_EQ(map.size(), 64);
+    EXPECT_EQ(map.capacity(), capacity);
+    for (u64 i = 100000 - 64; i < 100000; ++i) {
+        EXPECT_TRUE(map.contains(i));
+    }
+}
+
+TEST(HashMap, Iteration)
+{
+    lake::hash_map<u32, u32> map;
+    u64 expected_sum = 0;
+    for (u32 i = 0; i < 1000; ++i) {
+        map.insert(i, i * 2);
+        expected_sum += i * 2;
+    }
+    u64 sum = 0;
+    size_t count = 0;
+    for (auto const& entry : map) {
+        EXPECT_EQ(entry.value, entry.key * 2);
+        sum += entry.value;
+        ++count;
+    }
+    EXPECT_EQ(count, 1000);
+    EXPECT_EQ(sum, expected_sum);
+}
+
+TEST(HashMap, MoveOnlyValues)
+{
+    int destruction_count = 0;
+    {
+        lake::hash_map<u64, lake::unique_ptr<destruction_counter>> map;
+        for (u64 i = 0; i < 100; ++i) {
+            map.insert(i, lake::make_unique<destruction_counter>(&destruction_count));
+        }
+        EXPECT_EQ(destruction_count, 0);
+        map.remove(0);
+        EXPECT_EQ(destruction_count, 1);
+        map.insert_or_assign(1, lake::make_unique<destruction_counter>(&destruction_count));
+        EXPECT_EQ(destruction_count, 2);
+
+        auto moved = lake::move(map);
+        EXPECT_EQ(moved.size(), 99);
+        EXPECT_TRUE(map.empty());
+    }
+    EXPECT_EQ(destruction_count, 101);
+}
+
+TEST(HashMap, Allocator)
+{
+    counting_allocator::stats stats;
+    {
+        lake::hash_map<u64, u64, counting_allocator> map { counting_allocator(&stats) };
+        map.reserve(1000);
+        EXPECT_EQ(stats.allocations, 1);
+        auto capacity = map.capacity();
+        for (u64 i = 0; i < 1000; ++i) {
+            map.insert(i, i);
+        }
+        // Reserving must prevent rehashing.
+        EXPECT_EQ(map.capacity(), capacity);
+        EXPECT_EQ(stats.allocations, 1);
+    }
+    EXPECT_EQ(stats.allocations, 0);
+}
@@ -0,0 +1,80 @@
+/*
+ * SPDX-FileCopyrightText: 2023 Max Wipfli <mail@maxwipfli.ch>
+ * SPDX-LicenseIdentifier: MIT
+ */
+
+#include "utils.hpp"
+#include <algorithm>
+#include <gtest/gtest.h>
+#include <iterator>
+#include <lake/array.hpp>
+#include <lake/iterator.hpp>
+#include <lake/span.hpp>
+#include <lake/string.hpp>
+#include <lake/vector.hpp>
+#include <numeric>
+#include <ranges>
+
+static_assert(std::contiguous_iterator<lake::contiguous_iterator<int>>);
+static_assert(std::contiguous_iterator<lake::contiguous_iterator<int const>>);
+static_assert(std::contiguous_iterator<lake::vector<u64>::iterator>);
+static_assert(std::contiguous_iterator<lake::string::const_iterator>);
+static_assert(std::ranges::contiguous_range<lake::vector<u64>>);
+static_assert(std::ranges::contiguous_range<lake::span<int>>);
+static_assert(std::ranges::contiguous_range<lake::array<int, 4> const>);
+static_assert(std::is_same_v<std::iter_value_t<lake::contiguous_iterator<int const>>, int>);
+
+TEST(Iterator, Arithmetic)
+{
+    lake::array<int, 5> array = { 0, 1, 2, 3, 4 };
+    auto begin = array.begin();
+    auto end = array.end();
+    EXPECT_EQ(end - begin, 5);
+    EXPECT_EQ(*(begin + 2), 2);
+    EXPECT_EQ(*(2 + begin), 2);
+    EXPECT_EQ(*(end - 1), 4);
+    EXPECT_EQ(begin[3], 3);
+
+    auto it = begin;
+    it += 4;
+    EXPECT_EQ(*it, 4);
+    it -= 3;
+    EXPECT_EQ(*it, 1);
+    EXPECT_EQ(*it++, 1);
+    EXPECT_EQ(*it--, 2);
+    EXPECT_EQ(*--it, 0);
+    EXPECT_EQ(it, begin);
+
+    EXPECT_LT(begin, end);
+    EXPECT_LE(begin, begin);
+    EXPECT_GT(end, begin);
+    EXPECT_GE(end, end);
+    EXPECT_NE(begin, end);
+}
+
+TEST(Iterator, ConstConversion)
+{
+    lake::vector<int> vec = { 1, 2, 3 };
+    lake::vector<int>::const_iterator it = vec.begin();
+    EXPECT_EQ(*it, 1);
+    EXPECT_EQ(std::to_address(it), vec.data());
+    static_assert(!std::is_convertible_v<lake::vector<int>::const_iterator, lake::vector<int>::iterator>);
+}
+
+TEST(Iterator, StandardAlgorithms)
+{
+    lake::vector<int> vec;
+    for (int i = 0; i < 100; ++i) {
+        vec.push_back((i * 37) % 100);
+    }
+    std::sort(vec.begin(), vec.end());
+    EXPECT_TRUE(std::is_sorted(vec.begin(), vec.end()));
+    EXPECT_EQ(std::accumulate(vec.begin(), vec.end(), 0), 4950);
+    EXPECT_EQ(std::lower_bound(vec.begin(), vec.end(), 42) - vec.begin(), 42);
+
+    std::ranges::reverse(vec);
+    EXPECT_EQ(vec.front(), 99);
+    EXPECT_EQ(std::ranges::distance(vec), 100);
+    auto span = vec.span();
+    EXPECT_EQ(*std::ranges::max_element(span), 99);
+}
@@ -0,0 +1,146 @@
+/*
+ * SPDX-FileCopyrightText: 2023 Max Wipfli <mail@maxwipfli.ch>
+ * SPDX-LicenseIdentifier: MIT
+ */
+
+#include "utils.hpp"
+#include <gtest/gtest.h>
+#include <lake/mpmc_queue.hpp>
+#include <lake/unique_ptr.hpp>
+#include <pthread.h>
+#include <sched.h>
+
+TEST(MpmcQueue, Capacity)
+{
+    lake::mpmc_queue<int> queue(5);
+    EXPECT_EQ(queue.capacity(), 8);
+    EXPECT_TRUE(queue.empty());
+}
+
+TEST(MpmcQueue, TryPushPop)
+{
+    lake::mpmc_queue<int> queue(4);
+    EXPECT_FALSE(queue.try_pop().has_value());
+    for (int i = 0; i < 4; ++i) {
+        EXPECT_TRUE(queue.try_push(i));
+    }
+    EXPECT_FALSE(queue.try_push(4));
+    EXPECT_EQ(queue.size(), 4);
+
+    // Wrap around the end of the buffer several times.
+    for (int i = 4; i < 20; ++i) {
+        EXPECT_EQ(queue.try_pop().value(), i - 4);
+        EXPECT_TRUE(queue.try_push(i));
+    }
+    for (int i = 16; i < 20; ++i) {
+        EXPECT_EQ(queue.pop(), i);
+    }
+    EXPECT_TRUE(queue.empty());
+}
+
+TEST(MpmcQueue, MoveOnly)
+{
+    lake::mpmc_queue<lake::unique_ptr<int>> queue(2);
+    queue.push(lake::unique_ptr<int>::create({}, 7));
+    EXPECT_TRUE(queue.try_emplace(lake::unique_ptr<int>::create({}, 8)));
+    EXPECT_EQ(*queue.pop().ptr(), 7);
+    EXPECT_EQ(*queue.try_pop().value().ptr(), 8);
+}
+
+TEST(MpmcQueue, DestroysRemaining)
+{
+    int destruct_count = 0;
+    {
+        lake::mpmc_queue<destruction_counter> queue(8);
+        for (int i = 0; i < 5; ++i) {
+            queue.emplace(&destruct_count);
+        }
+        EXPECT_TRUE(queue.try_pop().has_value());
+        EXPECT_EQ(destruct_count, 1);
+    }
+    EXPECT_EQ(destruct_count, 5);
+}
+
+static constexpr u64 producer_count = 4;
+static constexpr u64 consumer_count = 4;
+static constexpr u64 items_per_producer = 20000;
+
+struct shared_state {
+    lake::mpmc_queue<u64> queue { 16 };
+    u64 sums[consumer_count] {};
+    u64 counts[consumer_count] {};
+};
+
+struct thread_argument {
+    shared_state* state;
+    u64 index;
+};
+
+// Producers alternate between blocking and non-blocking pushes, with values that identify the producer.
+static void* produce(void* argument)
+{
+    auto& [state, index] = *static_cast<thread_argument*>(argument);
+    for (u64 i = 0; i < items_per_producer; ++i) {
+        auto value = index * items_per_producer + i;
+        if (i % 2 == 0) {
+            state->queue.push(value);
+            continue;
+        }
+        while (!state->queue.try_push(value)) {
+            sched_yield();
+        }
+    }
+    return nullptr;
+}
+
+// Each consumer takes an equal share of the items, and stops at the marker value.
+static void* consume(void* argument)
+{
+    auto& [state, index] = *static_cast<thread_argument*>(argument);
+    while (true) {
+        auto value = state->queue.pop();
+        if (value == ~0ull) {
+            return nullptr;
+        }
+        state->sums[index] += value;
+        state->counts[index]++;
+    }
+}
+
+TEST(MpmcQueue, Threads)
+{
+    shared_state state;
+    pthread_t producers[producer_count];
+    pthread_t consumers[consumer_count];
+    thread_argument producer_arguments[producer_count];
+    thread_argument consumer_arguments[consumer_count];
+    for (u64 i = 0; i < consumer_count; ++i) {
+        consumer_arguments[i] = { &state, i };
+        pthread_create(&consumers[i], nullptr, consume, &consumer_arguments[i]);
+    }
+    for (u64 i = 0; i < producer_count; ++i) {
+        producer_arguments[i] = { &state, i };
+        pthread_create(&producers[i], nullptr, produce, &producer_arguments[i]);
+    }
+    for (auto& producer : producers) {
+        pthread_join(producer, nullptr);
+    }
+    for (u64 i = 0; i < consumer_count; ++i) {
+        state.queue.push(~0ull);
+    }
+    for (auto& consumer : consumers) {
+        pthread_join(consumer, nullptr);
+    }
+
+    // Every item was received exactly once.
+    u64 total = producer_count * items_per_producer;
+    u64 sum = 0;
+    u64 count = 0;
+    for (u64 i = 0; i < consumer_count; ++i) {
+        sum += state.sums[i];
+        count += state.counts[i];
+    }
+    EXPECT_EQ(count, total);
+    EXPECT_EQ(sum, total * (total - 1) / 2);
+    EXPECT_TRUE(state.queue.empty());
+}
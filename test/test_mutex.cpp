@@ -0,0 +1,222 @@
+/*
+ * SPDX-FileCopyrightText: 2023 Max Wipfli <mail@maxwipfli.ch>
+ * SPDX-LicenseIdentifier: MIT
+ */
+
+#include <gtest/gtest.h>
+#include <lake/mutex.hpp>
+#include <pthread.h>
+
+static constexpr size_t thread_count = 4;
+static constexpr size_t iterations = 20000;
+
+// A counter which is incremented non-atomically, so that lost updates show if the lock does not exclude other threads.
+template <typename Lock>
+struct locked_counter {
+    Lock lock;
+    u64 value { 0 };
+};
+
+template <typename Lock>
+static void* increment(void* argument)
+{
+    auto& counter = *static_cast<locked_counter<Lock>*>(argument);
+    for (size_t i = 0; i < iterations; ++i) {
+        lake::lock_guard guard(counter.lock);
+        auto value = counter.value;
+        counter.value = value + 1;
+    }
+    return nullptr;
+}
+
+template <typename Lock>
+static void run_threads(locked_counter<Lock>& counter)
+{
+    pthread_t threads[thread_count];
+    for (auto& thread : threads) {
+        pthread_create(&thread, nullptr, increment<Lock>, &counter);
+    }
+    for (auto& thread : threads) {
+        pthread_join(thread, nullptr);
+    }
+}
+
+TEST(Spinlock, TryLock)
+{
+    lake::spinlock lock;
+    EXPECT_TRUE(lock.try_lock());
+    EXPECT_FALSE(lock.try_lock());
+    lock.unlock();
+    EXPECT_TRUE(lock.try_lock());
+    lock.unlock();
+}
+
+TEST(Spinlock, Threads)
+{
+    locked_counter<lake::spinlock> counter;
+    run_threads(counter);
+    EXPECT_EQ(counter.value, thread_count * iterations);
+}
+
+TEST(RwSpinlock, Writers)
+{
+    locked_counter<lake::rw_spinlock> counter;
+    run_threads(counter);
+    EXPECT_EQ(counter.value, thread_count * iterations);
+}
+
+// Writers keep both halves equal under the exclusive lock, readers check them under the shared lock.
+struct rw_locked_pair {
+    lake::rw_spinlock lock;
+    u64 first { 0 };
+    u64 second { 0 };
+};
+
+static void* read_or_write_pair(void* argument)
+{
+    auto& pair = *static_cast<rw_locked_pair*>(argument);
+    for (size_t i = 0; i < iterations; ++i) {
+        if (i % 8 == 0) {
+            lake::lock_guard guard(pair.lock);
+            ++pair.first;
+            ++pair.second;
+        } else {
+            lake::shared_lock_guard guard(pair.lock);
+            if (pair.first != pair.second) {
+                return argument;
+            }
+        }
+    }
+    return nullptr;
+}
+
+TEST(RwSpinlock, ReadersAndWriters)
+{
+    rw_locked_pair pair;
+    pthread_t threads[thread_count];
+    for (auto& thread : threads) {
+        pthread_create(&thread, nullptr, read_or_write_pair, &pair);
+    }
+    for (auto& thread : threads) {
+        void* result;
+        pthread_join(thread, &result);
+        EXPECT_EQ(result, nullptr);
+    }
+    EXPECT_EQ(pair.first, thread_count * iterations / 8);
+}
+
+TEST(Mutex, TryLock)
+{
+    lake::mutex mutex;
+    EXPECT_TRUE(mutex.try_lock());
+    EXPECT_FALSE(mutex.try_lock());
+    mutex.unlock();
+    {
+        lake::lock_guard guard(mutex);
+        EXPECT_FALSE(mutex.try_lock());
+    }
+    EXPECT_TRUE(mutex.try_lock());
+    mutex.unlock();
+}
+
+TEST(Mutex, Threads)
+{
+    locked_counter<lake::mutex> counter;
+    run_threads(counter);
+    EXPECT_EQ(counter.value, thread_count * iterations);
+}
+
+// A bounded buffer of one element, passed back and forth between a producer and consumers.
+struct mailbox {
+    lake::mutex mutex;
+    lake::condition changed;
+    u64 value { 0 };
+    bool full { false };
+    bool closed { false };
+    u64 sum { 0 };
+};
+
+static void* take_all(void* argument)
+{
+    auto& box = *static_cast<mailbox*>(argument);
+    lake::lock_guard guard(box.mutex);
+    while (true) {
+        box.changed.wait(box.mutex, [&] { return box.full || box.closed; });
+        if (!box.full) {
+            return nullptr;
+        }
+        box.sum += box.value;
+        box.full = false;
+        box.changed.notify_all();
+    }
+}
+
+TEST(Condition, ProducerConsumers)
+{
+    mailbox box;
+    pthread_t consumers[3];
+    for (auto& consumer : consumers) {
+        pthread_create(&consumer, nullptr, take_all, &box);
+    }
+    for (u64 i = 1; i <= 1000; ++i) {
+        lake::lock_guard guard(box.mutex);
+        box.changed.wait(box.mutex, [&] { return !box.full; });
+        box.value = i;
+        box.full = true;
+        box.changed.notify_all();
+    }
+    {
+        lake::lock_guard guard(box.mutex);
+        box.changed.wait(box.mutex, [&] { return !box.full; });
+        box.closed = true;
+    }
+    box.changed.notify_all();
+    for (auto& consumer : consumers) {
+        pthread_join(consumer, nullptr);
+    }
+    EXPECT_EQ(box.sum, 1000 * 1001 / 2);
+}
+
+// Writers keep both halves equal, so readers must never see them differ.
+struct seqlocked_pair {
+    lake::seqlock lock;
+    u64 first { 0 };
+    u64 second { 0 };
+    lake::atomic<bool> stop { false };
+};
+
+static void* write_pairs(void* argument)
+{
+    auto& pair = *static_cast<seqlocked_pair*>(argument);
+    for (u64 i = 1; i <= 100000; ++i) {
+        pair.lock.write([&] {
+            pair.first = i;
+            pair.second = i;
+        });
+    }
+    pair.stop.store(true, lake::memory_order::release);
+    return nullptr;
+}
+
+struct pair_snapshot {
+    u64 first;
+    u64 second;
+};
+
+TEST(Seqlock, ReadersSeeConsistentData)
+{
+    seqlocked_pair pair;
+    pthread_t writer;
+    pthread_create(&writer, nullptr, write_pairs, &pair);
+    u64 last = 0;
+    while (!pair.stop.load(lake::memory_order::acquire)) {
+        auto snapshot = pair.lock.read([&] {
+            return pair_snapshot { __atomic_load_n(&pair.first, __ATOMIC_RELAXED), __atomic_load_n(&pair.second, __ATOMIC_RELAXED) };
+        });
+        ASSERT_EQ(snapshot.first, snapshot.second);
+        ASSERT_GE(snapshot.first, last);
+        last = snapshot.first;
+    }
+    pthread_join(writer, nullptr);
+    EXPECT_EQ(pair.lock.read([&] { return pair.first; }), 100000);
+}
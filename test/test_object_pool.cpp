@@ -0,0 +1,113 @@
+/*
+ * SPDX-FileCopyrightText: 2023 Max Wipfli <mail@maxwipfli.ch>
+ * SPDX-LicenseIdentifier: MIT
+ */
+
+#include "utils.hpp"
+#include <gtest/gtest.h>
+#include <lake/object_pool.hpp>
+#include <lake/vector.hpp>
+
+TEST(ObjectPool, Empty)
+{
+    lake::object_pool<u64> pool;
+    EXPECT_EQ(pool.size(), 0);
+    EXPECT_EQ(pool.capacity(), 0);
+}
+
+TEST(ObjectPool, CreateDestroy)
+{
+    int destruct_count = 0;
+    lake::object_pool<destruction_counter> pool;
+    auto* first = pool.create(&destruct_count);
+    auto* second = pool.create(&destruct_count);
+    EXPECT_NE(first, second);
+    EXPECT_EQ(pool.size(), 2);
+    EXPECT_EQ(pool.capacity(), pool.slots_per_slab());
+
+    pool.destroy(first);
+    EXPECT_EQ(destruct_count, 1);
+    EXPECT_EQ(pool.size(), 1);
+
+    // The most recently freed slot is reused first.
+    auto* third = pool.create(&destruct_count);
+    EXPECT_EQ(static_cast<void*>(third), static_cast<void*>(first));
+
+    pool.destroy(second);
+    pool.destroy(third);
+    EXPECT_EQ(destruct_count, 3);
+    EXPECT_EQ(pool.size(), 0);
+}
+
+TEST(ObjectPool, Slabs)
+{
+    struct alignas(32) message {
+        u64 id;
+        u8 payload[100];
+    };
+    lake::object_pool<message> pool(4096);
+    EXPECT_GT(pool.slots_per_slab(), 1);
+
+    lake::vector<message*> messages;
+    for (u64 i = 0; i < 1000; ++i) {
+        auto* msg = pool.create();
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(msg) % alignof(message), 0);
+        msg->id = i;
+        messages.push_back(msg);
+    }
+    EXPECT_EQ(pool.size(), 1000);
+    EXPECT_GE(pool.capacity(), 1000);
+    auto capacity = pool.capacity();
+
+    // Objects don't overlap.
+    for (u64 i = 0; i < 1000; ++i) {
+        EXPECT_EQ(messages[i]->id, i);
+    }
+
+    // Freed slots are reused without allocating new slabs.
+    for (auto* msg : messages) {
+        pool.destroy(msg);
+    }
+    for (u64 i = 0; i < 1000; ++i) {
+        messages[i] = pool.create();
+    }
+    EXPECT_EQ(pool.capacity(), capacity);
+    for (auto* msg : messages) {
+        pool.destroy(msg);
+    }
+}
+
+TEST(ObjectPool, TinySlabs)
+{
+    // Each slab holds at least one slot, even if it is larger than the requested slab size.
+    lake::object_pool<u64> pool(1);
+    EXPECT_EQ(pool.slots_per_slab(), 1);
+    auto* first = pool.create(1ull);
+    auto* second = pool.create(2ull);
+    EXPECT_EQ(*first, 1);
+    EXPECT_EQ(*second, 2);
+    EXPECT_EQ(pool.capacity(), 2);
+    pool.destroy(first);
+    pool.destroy(second);
+}
+
+TEST(ObjectPool, UniquePtr)
+{
+    int destruct_count = 0;
+    lake::object_pool<destruction_counter> pool;
+    {
+        auto ptr = pool.make_unique(&destruct_count);
+        EXPECT_TRUE(ptr);
+        EXPECT_EQ(pool.size(), 1);
+
+        auto other = lake::allocate_unique<destruction_counter>(lake::pool_allocator(pool), &destruct_count);
+        EXPECT_EQ(pool.size(), 2);
+
+        // The pool is carried along when the pointer is moved.
+        auto moved = lake::move(other);
+        EXPECT_EQ(moved.allocator(), lake::pool_allocator(pool));
+    }
+    // Destroyed objects are returned to the pool instead of being deleted.
+    EXPECT_EQ(destruct_count, 2);
+    EXPECT_EQ(pool.size(), 0);
+}
@@ -124,3 +124,32 @@ TEST(Optional, Alignment)
     auto alignment_mask = ~(alignof(three_member_struct) - 1);
     EXPECT_TRUE((struct_ptr & alignment_mask) == struct_ptr);
 }
+
+TEST(Optional, ConstructionForwards)
+{
+    copy_counter::counts counts;
+    copy_counter counter(&counts);
+
+    lake::optional<copy_counter> opt(counter);
+    EXPECT_EQ(counts.copies, 1);
+    EXPECT_EQ(counts.moves, 0);
+    opt.emplace(counter);
+    EXPECT_EQ(counts.copies, 2);
+    EXPECT_EQ(counts.moves, 0);
+    opt.emplace(lake::move(counter));
+    EXPECT_EQ(counts.copies, 2);
+    EXPECT_EQ(counts.moves, 1);
+    opt.emplace(&counts);
+    EXPECT_EQ(counts.copies, 2);
+    EXPECT_EQ(counts.moves, 1);
+
+    int value = 0;
+    lake::optional<reference_holder> holder(value);
+    EXPECT_EQ(&holder->reference(), &value);
+
+    // Moving an optional still uses the move constructor instead of constructing the value from the optional.
+    lake::optional<non_copyable> first = non_copyable();
+    lake::optional<non_copyable> second(lake::move(first));
+    EXPECT_TRUE(second.has_value());
+    EXPECT_FALSE(first.has_value());
+}
@@ -0,0 +1,107 @@
+/*
+ * SPDX-FileCopyrightText: 2023 Max Wipfli <mail@maxwipfli.ch>
+ * SPDX-LicenseIdentifier: MIT
+ */
+
+#include "utils.hpp"
+#include <gtest/gtest.h>
+#include <lake/page_allocator.hpp>
+#include <lake/vector.hpp>
+
+TEST(PageAllocator, Alignment)
+{
+    lake::page_allocator alloc;
+    auto page_size = lake::page_allocator::page_size();
+
+    auto* small = alloc.allocate(1, 1);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(small) % page_size, 0);
+    *static_cast<u8*>(small) = 1;
+    alloc.deallocate(small, 1, 1);
+
+    auto* aligned = alloc.allocate(100, 64 * 1024);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(aligned) % (64 * 1024), 0);
+    alloc.deallocate(aligned, 100, 64 * 1024);
+
+    // Allocations of at least a huge page are aligned to huge pages.
+    auto size = 3 * lake::page_allocator::huge_page_size;
+    auto* large = alloc.allocate(size, 8);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(large) % lake::page_allocator::huge_page_size, 0);
+    __builtin_memset(large, 0xab, size);
+    alloc.deallocate(large, size, 8);
+}
+
+TEST(PageAllocator, Reallocate)
+{
+    lake::page_allocator alloc;
+    size_t size = 1000;
+    auto* data = static_cast<u32*>(alloc.allocate(size * sizeof(u32), alignof(u32)));
+    for (u32 i = 0; i < size; ++i) {
+        data[i] = i;
+    }
+
+    // Grow, keeping the contents.
+    for (size_t new_size : { 5000, 1'000'000 }) {
+        data = static_cast<u32*>(alloc.reallocate(data, size * sizeof(u32), new_size * sizeof(u32), alignof(u32)));
+        for (u32 i = 0; i < size; ++i) {
+            ASSERT_EQ(data[i], i);
+        }
+        for (u32 i = size; i < new_size; ++i) {
+            data[i] = i;
+        }
+        size = new_size;
+    }
+
+    // Shrinking stays in place.
+    auto* shrunk = static_cast<u32*>(alloc.reallocate(data, size * sizeof(u32), 100 * sizeof(u32), alignof(u32)));
+    EXPECT_EQ(shrunk, data);
+    for (u32 i = 0; i < 100; ++i) {
+        ASSERT_EQ(shrunk[i], i);
+    }
+    alloc.deallocate(shrunk, 100 * sizeof(u32), alignof(u32));
+}
+
+TEST(PageAllocator, ReallocateKeepsHugePageAlignment)
+{
+    lake::page_allocator alloc;
+    auto page_size = lake::page_allocator::page_size();
+    auto huge_page_size = lake::page_allocator::huge_page_size;
+    size_t size = huge_page_size;
+    auto* data = static_cast<u8*>(alloc.allocate(size, 8));
+    __builtin_memset(data, 0xab, size);
+
+    for (size_t new_size : { 3 * huge_page_size, 5 * huge_page_size + 1, 16 * huge_page_size }) {
+        // A mapping right behind the allocation keeps it from growing in place, so it has to move.
+        auto* end = data + (size + page_size - 1) / page_size * page_size;
+        auto* blocker = mmap(end, page_size, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        data = static_cast<u8*>(alloc.reallocate(data, size, new_size, 8));
+        munmap(blocker, page_size);
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(data) % huge_page_size, 0);
+        for (size_t i = 0; i < size; i += page_size) {
+            ASSERT_EQ(data[i], 0xab);
+        }
+        __builtin_memset(data + size, 0xab, new_size - size);
+        size = new_size;
+    }
+
+    // Growing a small allocation past a huge page aligns it as well.
+    auto* small = alloc.allocate(page_size, 8);
+    small = alloc.reallocate(small, page_size, 2 * huge_page_size, 8);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(small) % huge_page_size, 0);
+    alloc.deallocate(small, 2 * huge_page_size, 8);
+    alloc.deallocate(data, size, 8);
+}
+
+TEST(PageAllocator, Vector)
+{
+    lake::vector<u64, lake::page_allocator> vec;
+    for (u64 i = 0; i < 1'000'000; ++i) {
+        vec.push_back(i);
+    }
+    for (u64 i = 0; i < 1'000'000; ++i) {
+        ASSERT_EQ(vec[i], i);
+    }
+
+    lake::vector<lake::vector<u64, lake::page_allocator>> nested;
+    nested.push_back(lake::move(vec));
+    EXPECT_EQ(nested[0].size(), 1'000'000);
+}
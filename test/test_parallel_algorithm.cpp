@@ -0,0 +1,158 @@
+/*
+ * SPDX-FileCopyrightText: 2023 Max Wipfli <mail@maxwipfli.ch>
+ * SPDX-LicenseIdentifier: MIT
+ */
+
+#include "utils.hpp"
+#include <gtest/gtest.h>
+#include <lake/parallel_algorithm.hpp>
+#include <lake/string.hpp>
+#include <lake/vector.hpp>
+
+TEST(ParallelAlgorithm, ForEach)
+{
+    lake::thread_pool pool(4);
+    lake::vector<u32> values;
+    values.resize(100000);
+    lake::parallel_for_each(pool, values.span(), [](u32& value) { value += 2; });
+    for (auto value : values) {
+        ASSERT_EQ(value, 2);
+    }
+
+    lake::parallel_for_each(values.span(), [](u32& value) { value *= 3; });
+    for (auto value : values) {
+        ASSERT_EQ(value, 6);
+    }
+}
+
+TEST(ParallelAlgorithm, Transform)
+{
+    lake::thread_pool pool(4);
+    lake::vector<u32> input;
+    input.resize(50000);
+    for (u32 i = 0; i < input.size(); ++i) {
+        input[i] = i;
+    }
+    lake::vector<u64> output;
+    output.resize(input.size());
+    lake::parallel_transform(pool, lake::span<u32 const>(input.data(), input.size()), output.span(),
+        [](u32 value) { return u64 { value } * value; });
+    for (u32 i = 0; i < input.size(); ++i) {
+        ASSERT_EQ(output[i], u64 { i } * i);
+    }
+
+    lake::vector<u8> bytes;
+    bytes.resize(input.size());
+    lake::parallel_transform(input.span(), bytes.span(), [](u32 value) { return static_cast<u8>(value); });
+    for (u32 i = 0; i < input.size(); ++i) {
+        ASSERT_EQ(bytes[i], static_cast<u8>(i));
+    }
+}
+
+TEST(ParallelAlgorithm, SortIntegers)
+{
+    lake::thread_pool pool(4);
+    for (size_t size : { 0, 1, 1000, 100000, 1000000 }) {
+        lake::vector<u64> values;
+        values.resize(size);
+        u64 state = 42 + size;
+        u64 sum = 0;
+        for (auto& value : values) {
+            value = next_random(state);
+            sum += value;
+        }
+        lake::parallel_sort(pool, values.span());
+        EXPECT_TRUE(lake::is_sorted(values.span())) << "size " << size;
+        for (auto value : values) {
+            sum -= value;
+        }
+        EXPECT_EQ(sum, 0);
+    }
+}
+
+TEST(ParallelAlgorithm, SortPatterns)
+{
+    lake::thread_pool pool(4);
+    size_t const size = 200000;
+    lake::vector<int> values;
+    values.resize(size);
+
+    // sorted, reversed, all equal, and only a few distinct values
+    for (size_t i = 0; i < size; ++i) {
+        values[i] = static_cast<int>(i);
+    }
+    lake::parallel_sort(pool, values.span());
+    EXPECT_TRUE(lake::is_sorted(values.span()));
+
+    for (size_t i = 0; i < size; ++i) {
+        values[i] = static_cast<int>(size - i);
+    }
+    lake::parallel_sort(pool, values.span());
+    EXPECT_TRUE(lake::is_sorted(values.span()));
+
+    for (auto& value : values) {
+        value = 7;
+    }
+    lake::parallel_sort(pool, values.span());
+    EXPECT_TRUE(lake::is_sorted(values.span()));
+
+    u64 state = 1;
+    size_t counts[4] = {};
+    for (auto& value : values) {
+        value = static_cast<int>(next_random(state) % 4) - 2;
+        counts[value + 2]++;
+    }
+    lake::parallel_sort(pool, values.span());
+    EXPECT_TRUE(lake::is_sorted(values.span()));
+    EXPECT_EQ(values[0], -2);
+    EXPECT_EQ(values[counts[0]], -1);
+    EXPECT_EQ(values[size - 1], 1);
+}
+
+TEST(ParallelAlgorithm, SortWithComparison)
+{
+    lake::thread_pool pool(3);
+    lake::vector<i32> values;
+    values.resize(300000);
+    u64 state = 7;
+    for (auto& value : values) {
+        value = static_cast<i32>(next_random(state));
+    }
+    auto greater = [](i32 first, i32 second) { return first > second; };
+    lake::parallel_sort(pool, values.span(), greater);
+    EXPECT_TRUE(lake::is_sorted(values.span(), greater));
+}
+
+TEST(ParallelAlgorithm, SortNonTrivial)
+{
+    lake::thread_pool pool(4);
+    lake::vector<lake::string> values;
+    u64 state = 3;
+    for (size_t i = 0; i < 50000; ++i) {
+        char buffer[32];
+        auto length = next_random(state) % sizeof(buffer);
+        for (size_t j = 0; j < length; ++j) {
+            buffer[j] = static_cast<char>('a' + next_random(state) % 4);
+        }
+        values.push_back(lake::string(lake::string_view(buffer, length)));
+    }
+    auto less = [](lake::string const& first, lake::string const& second) {
+        auto common = first.size() < second.size() ? first.size() : second.size();
+        auto result = common > 0 ? __builtin_memcmp(first.data(), second.data(), common) : 0;
+        return result < 0 || (result == 0 && first.size() < second.size());
+    };
+    lake::parallel_sort(pool, values.span(), less);
+    EXPECT_TRUE(lake::is_sorted(values.span(), less));
+}
+
+TEST(ParallelAlgorithm, SortGlobal)
+{
+    lake::vector<u32> values;
+    values.resize(100000);
+    u64 state = 5;
+    for (auto& value : values) {
+        value = static_cast<u32>(next_random(state));
+    }
+    lake::parallel_sort(values.span());
+    EXPECT_TRUE(lake::is_sorted(values.span()));
+}
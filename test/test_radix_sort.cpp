@@ -0,0 +1,111 @@
+/*
+ * SPDX-FileCopyrightText: 2023 Max Wipfli <mail@maxwipfli.ch>
+ * SPDX-LicenseIdentifier: MIT
+ */
+
+#include "utils.hpp"
+#include <algorithm>
+#include <gtest/gtest.h>
+#include <lake/algorithm.hpp>
+#include <lake/radix_sort.hpp>
+#include <lake/string.hpp>
+#include <lake/vector.hpp>
+
+// A simple, deterministic pseudo-random number generator (xorshift).
+template <typename T>
+static void check_sorts_integers(u64 mask)
+{
+    for (size_t size : { 0, 1, 2, 63, 64, 65, 1000, 100000 }) {
+        lake::vector<T> values;
+        u64 seed = size + 1;
+        for (size_t i = 0; i < size; ++i) {
+            values.push_back(static_cast<T>(next_random(seed) & mask));
+        }
+        lake::vector<T> expected(values.span());
+        std::sort(expected.begin(), expected.end());
+
+        lake::radix_sort(values.span());
+        ASSERT_EQ(values, expected) << "size " << size;
+    }
+}
+
+TEST(RadixSort, Unsigned)
+{
+    check_sorts_integers<u8>(~0ull);
+    check_sorts_integers<u16>(~0ull);
+    check_sorts_integers<u32>(~0ull);
+    check_sorts_integers<u64>(~0ull);
+    // Only the lower digits differ, so the passes for the upper ones are skipped.
+    check_sorts_integers<u64>(0xfff);
+    check_sorts_integers<u32>(0xff00);
+}
+
+TEST(RadixSort, Signed)
+{
+    check_sorts_integers<i8>(~0ull);
+    check_sorts_integers<i32>(~0ull);
+    check_sorts_integers<i64>(~0ull);
+    check_sorts_integers<i64>(0x8000'0000'0000'00ffull);
+}
+
+struct record {
+    u32 key;
+    u32 index;
+};
+
+TEST(RadixSort, KeyIsStable)
+{
+    for (size_t size : { 50, 10000 }) {
+        lake::vector<record> records;
+        u64 seed = 1;
+        for (u32 i = 0; i < size; ++i) {
+            records.push_back(record { static_cast<u32>(next_random(seed) % 100), i });
+        }
+
+        // A reusable scratch buffer.
+        lake::vector<record> scratch;
+        scratch.resize_for_overwrite(records.size());
+        lake::radix_sort(records.span(), scratch.span(), [](record const& r) { return r.key; });
+
+        for (size_t i = 1; i < records.size(); ++i) {
+            ASSERT_LE(records[i - 1].key, records[i].key);
+            if (records[i - 1].key == records[i].key) {
+                ASSERT_LT(records[i - 1].index, records[i].index);
+            }
+        }
+    }
+}
+
+TEST(RadixSort, Strings)
+{
+    lake::vector<lake::string> storage;
+    u64 seed = 1;
+    char const* prefixes[] = { "", "a", "ab", "abc", "2023-11-02T", "2023-11-02T12:", "\xff" };
+    for (size_t i = 0; i < 20000; ++i) {
+        lake::string str = prefixes[next_random(seed) % 7];
+        auto length = next_random(seed) % 6;
+        for (size_t j = 0; j < length; ++j) {
+            str.append(static_cast<char>('0' + next_random(seed) % 4));
+        }
+        storage.push_back(lake::move(str));
+    }
+
+    for (size_t size : { 0, 1, 15, 16, 100, 20000 }) {
+        lake::vector<lake::string_view> values;
+        for (size_t i = 0; i < size; ++i) {
+            values.push_back(storage[i].view());
+        }
+        lake::vector<lake::string_view> expected(values.span());
+        lake::sort(expected.span(), [](lake::string_view a, lake::string_view b) {
+            // memcmp() compares bytes as unsigned values.
+            auto common = a.size() < b.size() ? a.size() : b.size();
+            auto result = common > 0 ? __builtin_memcmp(a.data(), b.data(), common) : 0;
+            return result < 0 || (result == 0 && a.size() < b.size());
+        });
+
+        lake::radix_sort(values.span());
+        for (size_t i = 0; i < size; ++i) {
+            ASSERT_EQ(values[i], expected[i]) << "size " << size << ", index " << i;
+        }
+    }
+}
@@ -0,0 +1,210 @@
+/*
+ * SPDX-FileCopyrightText: 2023 Max Wipfli <mail@maxwipfli.ch>
+ * SPDX-LicenseIdentifier: MIT
+ */
+
+#include "utils.hpp"
+#include <gtest/gtest.h>
+#include <lake/ref_ptr.hpp>
+#include <lake/vector.hpp>
+#include <pthread.h>
+
+namespace {
+
+class counted : public lake::ref_counted {
+public:
+    explicit counted(int* destruct_count, int value = 0)
+        : m_destruct_count(destruct_count)
+        , m_value(value)
+    {
+    }
+    virtual ~counted() { (*m_destruct_count)++; }
+
+    [[nodiscard]] int value() const { return m_value; }
+
+private:
+    int* m_destruct_count;
+    int m_value;
+};
+
+class derived : public counted {
+public:
+    using counted::counted;
+};
+
+class atomic_counted : public lake::atomic_ref_counted {
+public:
+    explicit atomic_counted(int* destruct_count)
+        : m_destruct_count(destruct_count)
+    {
+    }
+    ~atomic_counted() { (*m_destruct_count)++; }
+
+private:
+    int* m_destruct_count;
+};
+
+}
+
+static_assert(sizeof(lake::ref_ptr<counted>) == sizeof(void*));
+static_assert(lake::is_trivially_relocatable_v<lake::ref_ptr<counted>>);
+static_assert(lake::is_same_v<lake::ref_ptr<atomic_counted>, lake::atomic_ref_ptr<atomic_counted>>);
+
+TEST(RefPtr, Null)
+{
+    lake::ref_ptr<counted> ptr;
+    EXPECT_EQ(ptr.ptr(), nullptr);
+    EXPECT_FALSE(ptr);
+    EXPECT_EQ(ptr.ref_count(), 0);
+    ptr.clear();
+    EXPECT_FALSE(ptr);
+
+    EXPECT_DEATH((void)*ptr, "");
+}
+
+TEST(RefPtr, Intrusive)
+{
+    int destruct_count = 0;
+    {
+        auto ptr = lake::make_ref_counted<counted>(&destruct_count, 42);
+        EXPECT_TRUE(ptr);
+        EXPECT_EQ(ptr->value(), 42);
+        EXPECT_EQ(ptr.ref_count(), 1);
+        {
+            auto copy = ptr;
+            EXPECT_EQ(copy, ptr);
+            EXPECT_EQ(ptr.ref_count(), 2);
+            EXPECT_EQ(ptr->ref_count(), 2);
+        }
+        EXPECT_EQ(ptr.ref_count(), 1);
+        EXPECT_EQ(destruct_count, 0);
+    }
+    EXPECT_EQ(destruct_count, 1);
+}
+
+TEST(RefPtr, AdoptAndRetain)
+{
+    int destruct_count = 0;
+    auto ptr = lake::adopt_ref(new counted(&destruct_count));
+    EXPECT_EQ(ptr.ref_count(), 1);
+
+    // A ref_ptr can be created from a raw pointer to an intrusively counted object, which adds a reference.
+    lake::ref_ptr<counted> retained(ptr.ptr());
+    EXPECT_EQ(ptr.ref_count(), 2);
+
+    ptr.clear();
+    EXPECT_EQ(destruct_count, 0);
+    EXPECT_EQ(retained.ref_count(), 1);
+    retained.clear();
+    EXPECT_EQ(destruct_count, 1);
+}
+
+TEST(RefPtr, MoveDoesNotTouchCount)
+{
+    int destruct_count = 0;
+    auto ptr = lake::make_ref_counted<counted>(&destruct_count);
+    auto* raw = ptr.ptr();
+
+    lake::ref_ptr<counted> moved(move(ptr));
+    EXPECT_FALSE(ptr);
+    EXPECT_EQ(moved.ptr(), raw);
+    EXPECT_EQ(moved.ref_count(), 1);
+
+    lake::ref_ptr<counted> assigned;
+    assigned = move(moved);
+    EXPECT_FALSE(moved);
+    EXPECT_EQ(assigned.ref_count(), 1);
+
+    // Self-assignment keeps the object alive.
+    auto& alias = assigned;
+    assigned = alias;
+    assigned = move(alias);
+    EXPECT_EQ(assigned.ref_count(), 1);
+    EXPECT_EQ(destruct_count, 0);
+}
+
+TEST(RefPtr, Conversions)
+{
+    int destruct_count = 0;
+    {
+        lake::ref_ptr<counted> base = lake::make_ref_counted<derived>(&destruct_count, 3);
+        EXPECT_EQ(base->value(), 3);
+
+        lake::ref_ptr<counted const> immutable = base;
+        EXPECT_EQ(immutable->value(), 3);
+        EXPECT_EQ(base.ref_count(), 2);
+    }
+    EXPECT_EQ(destruct_count, 1);
+}
+
+TEST(RefPtr, NonIntrusive)
+{
+    int destruct_count = 0;
+    {
+        auto ptr = lake::make_ref_counted<destruction_counter>(&destruct_count);
+        EXPECT_EQ(ptr.ref_count(), 1);
+        auto copy = ptr;
+        EXPECT_EQ(ptr.ref_count(), 2);
+
+        lake::ref_ptr<destruction_counter const> immutable = move(copy);
+        EXPECT_EQ(immutable.ref_count(), 2);
+        EXPECT_EQ(immutable.ptr(), ptr.ptr());
+    }
+    EXPECT_EQ(destruct_count, 1);
+
+    // The count is placed in front of over-aligned objects as well.
+    struct alignas(64) aligned {
+        u8 bytes[64];
+    };
+    auto ptr = lake::make_ref_counted<aligned>();
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(ptr.ptr()) % 64, 0);
+    auto copy = ptr;
+    EXPECT_EQ(copy.ref_count(), 2);
+}
+
+TEST(RefPtr, InVector)
+{
+    int destruct_count = 0;
+    {
+        auto ptr = lake::make_ref_counted<counted>(&destruct_count);
+        lake::vector<lake::ref_ptr<counted>> vec;
+        for (size_t i = 0; i < 100; ++i) {
+            vec.push_back(ptr);
+        }
+        EXPECT_EQ(ptr.ref_count(), 101);
+        vec.clear();
+        EXPECT_EQ(ptr.ref_count(), 1);
+    }
+    EXPECT_EQ(destruct_count, 1);
+}
+
+static void* copy_and_drop(void* arg)
+{
+    auto const& ptr = *static_cast<lake::atomic_ref_ptr<atomic_counted> const*>(arg);
+    for (size_t i = 0; i < 100000; ++i) {
+        auto copy = ptr;
+    }
+    return nullptr;
+}
+
+TEST(RefPtr, Atomic)
+{
+    int destruct_count = 0;
+    {
+        auto ptr = lake::make_ref_counted<atomic_counted>(&destruct_count);
+        pthread_t threads[4];
+        for (auto& thread : threads) {
+            pthread_create(&thread, nullptr, copy_and_drop, &ptr);
+        }
+        for (auto& thread : threads) {
+            pthread_join(thread, nullptr);
+        }
+        EXPECT_EQ(ptr.ref_count(), 1);
+
+        auto non_intrusive = lake::make_atomic_ref_counted<int>(5);
+        auto copy = non_intrusive;
+        EXPECT_EQ(*copy, 5);
+        EXPECT_EQ(copy.ref_count(), 2);
+    }
+    EXPECT_EQ(destruct_count, 1);
+}
@@ -0,0 +1,133 @@
+/*
+ * SPDX-FileCopyrightText: 2023 Max Wipfli <mail@maxwipfli.ch>
+ * SPDX-LicenseIdentifier: MIT
+ */
+
+#include "utils.hpp"
+#include <gtest/gtest.h>
+#include <lake/array.hpp>
+#include <lake/small_vector.hpp>
+#include <lake/unique_ptr.hpp>
+
+TEST(SmallVector, Empty)
+{
+    lake::small_vector<u16, 4> vec;
+    EXPECT_EQ(vec.size(), 0);
+    EXPECT_TRUE(vec.empty());
+    EXPECT_TRUE(vec.is_inline());
+    EXPECT_EQ(vec.capacity(), 4);
+    EXPECT_EQ(vec.begin(), vec.end());
+    EXPECT_EQ(vec.span(), lake::span<u16>());
+
+    EXPECT_DEATH((void)vec[0], "");
+    EXPECT_DEATH((void)vec.front(), "");
+    EXPECT_DEATH((void)vec.back(), "");
+}
+
+TEST(SmallVector, InlineAndHeap)
+{
+    counting_allocator::stats stats;
+    lake::small_vector<u32, 4, counting_allocator> vec(counting_allocator { &stats });
+    for (u32 i = 0; i < 4; ++i) {
+        vec.push_back(i);
+    }
+    // The inline storage must be used before allocating.
+    EXPECT_TRUE(vec.is_inline());
+    EXPECT_EQ(stats.allocations, 0);
+
+    vec.push_back(4);
+    EXPECT_FALSE(vec.is_inline());
+    EXPECT_EQ(stats.allocations, 1);
+    EXPECT_GE(vec.capacity(), 5);
+    for (u32 i = 0; i < 5; ++i) {
+        EXPECT_EQ(vec[i], i);
+    }
+
+    vec.clear();
+    EXPECT_TRUE(vec.is_inline());
+    EXPECT_EQ(stats.allocations, 0);
+}
+
+TEST(SmallVector, DestructionCounts)
+{
+    int destruction_count = 0;
+    {
+        lake::small_vector<destruction_counter, 2> vec;
+        for (int i = 0; i < 8; ++i) {
+            vec.emplace_back(&destruction_count);
+        }
+        // Moving elements from inline to heap storage must not destroy them.
+        EXPECT_EQ(destruction_count, 0);
+        vec.pop_back();
+        EXPECT_EQ(destruction_count, 1);
+    }
+    EXPECT_EQ(destruction_count, 8);
+}
+
+TEST(SmallVector, NonCopyable)
+{
+    lake::small_vector<non_copyable, 4> vec;
+    for (size_t i = 0; i < 16; ++i) {
+        vec.push_back(non_copyable());
+    }
+    EXPECT_EQ(vec.back().dummy(), non_copyable::expected_dummy());
+}
+
+TEST(SmallVector, MoveInline)
+{
+    int destruction_count = 0;
+    {
+        lake::small_vector<lake::unique_ptr<destruction_counter>, 4> vec;
+        vec.push_back(lake::make_unique<destruction_counter>(&destruction_count));
+        vec.push_back(lake::make_unique<destruction_counter>(&destruction_count));
+        auto* first = vec[0].ptr();
+
+        auto moved = lake::move(vec);
+        EXPECT_TRUE(moved.is_inline());
+        EXPECT_EQ(moved.size(), 2);
+        EXPECT_EQ(moved[0].ptr(), first);
+        EXPECT_TRUE(vec.empty());
+        EXPECT_EQ(destruction_count, 0);
+    }
+    EXPECT_EQ(destruction_count, 2);
+}
+
+TEST(SmallVector, MoveHeap)
+{
+    lake::small_vector<int, 2> vec = { 1, 2, 3, 4 };
+    EXPECT_FALSE(vec.is_inline());
+    auto* data = vec.data();
+
+    lake::small_vector<int, 2> moved;
+    moved = lake::move(vec);
+    // Heap storage is taken over without copying.
+    EXPECT_EQ(moved.data(), data);
+    EXPECT_EQ(moved.size(), 4);
+    EXPECT_TRUE(vec.empty());
+    EXPECT_TRUE(vec.is_inline());
+}
+
+TEST(SmallVector, FromSpan)
+{
+    lake::array<int, 4> data = { 1, 2, 3, 4 };
+    lake::small_vector<int, 8> vec = data.span();
+    EXPECT_EQ(vec, data.span());
+
+    lake::array<int, 2> smaller = { 5, 6 };
+    vec = smaller.span();
+    EXPECT_EQ(vec, smaller.span());
+
+    lake::span<int> span = vec;
+    EXPECT_EQ(span.data(), vec.data());
+}
+
+TEST(SmallVector, Swap)
+{
+    lake::small_vector<int, 2> first = { 1 };
+    lake::small_vector<int, 2> second = { 2, 3, 4 };
+    first.swap(second);
+    EXPECT_EQ(first.size(), 3);
+    EXPECT_EQ(first[2], 4);
+    EXPECT_EQ(second.size(), 1);
+    EXPECT_EQ(second[0], 1);
+}
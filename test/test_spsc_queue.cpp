@@ -0,0 +1,141 @@
+/*
+ * SPDX-FileCopyrightText: 2023 Max Wipfli <mail@maxwipfli.ch>
+ * SPDX-LicenseIdentifier: MIT
+ */
+
+#include "utils.hpp"
+#include <gtest/gtest.h>
+#include <lake/spsc_queue.hpp>
+#include <lake/unique_ptr.hpp>
+#include <lake/vector.hpp>
+#include <pthread.h>
+#include <sched.h>
+
+TEST(SpscQueue, Capacity)
+{
+    lake::spsc_queue<int> queue(100);
+    EXPECT_EQ(queue.capacity(), 128);
+    EXPECT_TRUE(queue.empty());
+}
+
+TEST(SpscQueue, PushPop)
+{
+    lake::spsc_queue<int> queue(4);
+    EXPECT_FALSE(queue.try_pop().has_value());
+    for (int i = 0; i < 4; ++i) {
+        EXPECT_TRUE(queue.try_push(i));
+    }
+    EXPECT_FALSE(queue.try_push(4));
+    EXPECT_EQ(queue.size(), 4);
+
+    // Wrap around the end of the buffer several times.
+    for (int i = 4; i < 20; ++i) {
+        auto value = queue.try_pop();
+        ASSERT_TRUE(value.has_value());
+        EXPECT_EQ(value.value(), i - 4);
+        EXPECT_TRUE(queue.try_push(i));
+    }
+    for (int i = 16; i < 20; ++i) {
+        EXPECT_EQ(queue.try_pop().value(), i);
+    }
+    EXPECT_TRUE(queue.empty());
+}
+
+TEST(SpscQueue, MoveOnly)
+{
+    lake::spsc_queue<lake::unique_ptr<int>> queue(2);
+    EXPECT_TRUE(queue.try_emplace(lake::unique_ptr<int>::create({}, 7)));
+    auto value = queue.try_pop();
+    ASSERT_TRUE(value.has_value());
+    EXPECT_EQ(*value.value().ptr(), 7);
+}
+
+TEST(SpscQueue, DestroysRemaining)
+{
+    int destruct_count = 0;
+    {
+        lake::spsc_queue<destruction_counter> queue(8);
+        for (int i = 0; i < 5; ++i) {
+            EXPECT_TRUE(queue.try_emplace(&destruct_count));
+        }
+        EXPECT_TRUE(queue.try_pop().has_value());
+        EXPECT_EQ(destruct_count, 1);
+    }
+    EXPECT_EQ(destruct_count, 5);
+}
+
+TEST(SpscQueue, Batches)
+{
+    lake::spsc_queue<u32> queue(8);
+    u32 input[] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+    EXPECT_EQ(queue.push_n(lake::span<u32>(input, 5)), 5);
+    // Only three more fit.
+    EXPECT_EQ(queue.push_n(lake::span<u32>(input + 5, 5)), 3);
+
+    u32 output[6] = {};
+    EXPECT_EQ(queue.pop_n(lake::span<u32>(output, 6)), 6);
+    for (u32 i = 0; i < 6; ++i) {
+        EXPECT_EQ(output[i], i);
+    }
+    // This batch wraps around the end of the buffer.
+    EXPECT_EQ(queue.push_n(lake::span<u32>(input + 8, 2)), 2);
+    EXPECT_EQ(queue.pop_n(lake::span<u32>(output, 6)), 4);
+    for (u32 i = 0; i < 4; ++i) {
+        EXPECT_EQ(output[i], i + 6);
+    }
+    EXPECT_EQ(queue.pop_n(lake::span<u32>(output, 6)), 0);
+}
+
+static constexpr u64 thread_item_count = 200000;
+
+static void* produce(void* argument)
+{
+    auto& queue = *static_cast<lake::spsc_queue<u64>*>(argument);
+    u64 batch[16];
+    u64 next = 0;
+    while (next < thread_item_count) {
+        // Alternate between single elements and batches.
+        if (next % 2 == 0) {
+            if (queue.try_push(next)) {
+                ++next;
+            } else {
+                // Let the consumer run on machines with fewer cores than threads.
+                sched_yield();
+            }
+            continue;
+        }
+        size_t count = 0;
+        while (count < 16 && next + count < thread_item_count) {
+            batch[count] = next + count;
+            ++count;
+        }
+        auto pushed = queue.push_n(lake::span<u64>(batch, count));
+        if (pushed == 0) {
+            sched_yield();
+        }
+        next += pushed;
+    }
+    return nullptr;
+}
+
+TEST(SpscQueue, Threads)
+{
+    lake::spsc_queue<u64> queue(64);
+    pthread_t producer;
+    pthread_create(&producer, nullptr, produce, &queue);
+
+    u64 expected = 0;
+    u64 batch[8];
+    while (expected < thread_item_count) {
+        auto count = queue.pop_n(lake::span<u64>(batch, expected % 3 == 0 ? 1 : 8));
+        if (count == 0) {
+            sched_yield();
+        }
+        for (size_t i = 0; i < count; ++i) {
+            ASSERT_EQ(batch[i], expected);
+            ++expected;
+        }
+    }
+    pthread_join(producer, nullptr);
+    EXPECT_TRUE(queue.empty());
+}
@@ -0,0 +1,113 @@
+/*
+ * SPDX-FileCopyrightText: 2023 Max Wipfli <mail@maxwipfli.ch>
+ * SPDX-LicenseIdentifier: MIT
+ */
+
+#include "utils.hpp"
+#include <gtest/gtest.h>
+#include <lake/array.hpp>
+#include <lake/static_vector.hpp>
+
+TEST(StaticVector, Empty)
+{
+    lake::static_vector<u16, 4> vec;
+    EXPECT_EQ(vec.size(), 0);
+    EXPECT_EQ(vec.capacity(), 4);
+    EXPECT_TRUE(vec.empty());
+    EXPECT_FALSE(vec.full());
+    EXPECT_EQ(vec.begin(), vec.end());
+    EXPECT_EQ(vec.span(), lake::span<u16>());
+
+    EXPECT_DEATH((void)vec[0], "");
+    EXPECT_DEATH((void)vec.front(), "");
+    EXPECT_DEATH((void)vec.back(), "");
+    EXPECT_DEATH(vec.pop_back(), "");
+}
+
+TEST(StaticVector, Basic)
+{
+    lake::static_vector<int, 3> vec;
+    vec.push_back(1);
+    vec.push_back(2);
+    vec.emplace_back(3);
+    EXPECT_TRUE(vec.full());
+    EXPECT_EQ(vec.size(), 3);
+    EXPECT_EQ(vec[0], 1);
+    EXPECT_EQ(vec[1], 2);
+    EXPECT_EQ(vec[2], 3);
+
+    vec.pop_back();
+    EXPECT_EQ(vec.size(), 2);
+    EXPECT_EQ(vec.back(), 2);
+}
+
+TEST(StaticVector, Overflow)
+{
+    lake::static_vector<int, 2> vec;
+    EXPECT_TRUE(vec.try_push_back(1));
+    EXPECT_TRUE(vec.try_emplace_back(2));
+    EXPECT_FALSE(vec.try_push_back(3));
+    EXPECT_EQ(vec.size(), 2);
+    EXPECT_EQ(vec.back(), 2);
+
+    EXPECT_DEATH(vec.push_back(3), "");
+}
+
+constexpr lake::static_vector<int, 8> make_squares(int count)
+{
+    lake::static_vector<int, 8> vec;
+    for (int i = 0; i < count; ++i) {
+        vec.push_back(i * i);
+    }
+    return vec;
+}
+
+TEST(StaticVector, Constexpr)
+{
+    constexpr auto squares = make_squares(5);
+    static_assert(squares.size() == 5);
+    static_assert(squares[4] == 16);
+    static_assert(squares.span() == lake::array<int, 5> { 0, 1, 4, 9, 16 }.span());
+
+    static_assert(__is_trivially_copyable(lake::static_vector<int, 8>));
+}
+
+TEST(StaticVector, DestructionCounts)
+{
+    int destruction_count = 0;
+    {
+        lake::static_vector<destruction_counter, 4> vec;
+        vec.emplace_back(&destruction_count);
+        vec.emplace_back(&destruction_count);
+        vec.emplace_back(&destruction_count);
+        vec.pop_back();
+        EXPECT_EQ(destruction_count, 1);
+
+        auto moved = lake::move(vec);
+        EXPECT_TRUE(vec.empty());
+        EXPECT_EQ(moved.size(), 2);
+    }
+    EXPECT_EQ(destruction_count, 3);
+}
+
+TEST(StaticVector, NonCopyable)
+{
+    lake::static_vector<non_copyable, 4> vec;
+    vec.push_back(non_copyable());
+    vec.emplace_back();
+    EXPECT_EQ(vec.back().dummy(), non_copyable::expected_dummy());
+}
+
+TEST(StaticVector, FromSpan)
+{
+    lake::array<int, 4> data = { 1, 2, 3, 4 };
+    lake::static_vector<int, 8> vec = data.span();
+    EXPECT_EQ(vec, data.span());
+
+    lake::span<int> span = vec;
+    EXPECT_EQ(span.data(), vec.data());
+    EXPECT_EQ(span.size(), 4);
+
+    lake::static_vector<int, 4> other = { 1, 2, 3, 4 };
+    EXPECT_EQ(vec, other);
+}
@@ -0,0 +1,196 @@
+/*
+ * SPDX-FileCopyrightText: 2023 Max Wipfli <mail@maxwipfli.ch>
+ * SPDX-LicenseIdentifier: MIT
+ */
+
+#include "utils.hpp"
+#include <gtest/gtest.h>
+#include <lake/hash.hpp>
+#include <lake/string.hpp>
+#include <lake/vector.hpp>
+
+static_assert(sizeof(lake::string) == 24);
+static_assert(lake::is_trivially_relocatable_v<lake::string>);
+
+TEST(String, Empty)
+{
+    lake::string str;
+    EXPECT_EQ(str.size(), 0);
+    EXPECT_TRUE(str.empty());
+    EXPECT_TRUE(str.is_inline());
+    EXPECT_EQ(str.capacity(), lake::string::inline_capacity);
+    EXPECT_STREQ(str.c_str(), "");
+    EXPECT_EQ(str, "");
+
+    EXPECT_DEATH((void)str[0], "");
+    EXPECT_DEATH((void)str.front(), "");
+    EXPECT_DEATH((void)str.back(), "");
+}
+
+TEST(String, Inline)
+{
+    counting_allocator::stats stats;
+    lake::basic_string<counting_allocator> str("identifier", counting_allocator { &stats });
+    EXPECT_TRUE(str.is_inline());
+    EXPECT_EQ(stats.allocations, 0);
+    EXPECT_EQ(str.size(), 10);
+    EXPECT_EQ(str, "identifier");
+    EXPECT_STREQ(str.c_str(), "identifier");
+    EXPECT_EQ(str.front(), 'i');
+    EXPECT_EQ(str.back(), 'r');
+
+    // The full inline capacity can be used, with the last byte doubling as the null terminator.
+    lake::basic_string<counting_allocator> full("0123456789abcdefghijklm", counting_allocator { &stats });
+    EXPECT_TRUE(full.is_inline());
+    EXPECT_EQ(stats.allocations, 0);
+    EXPECT_EQ(full.size(), 23);
+    EXPECT_STREQ(full.c_str(), "0123456789abcdefghijklm");
+}
+
+TEST(String, Heap)
+{
+    counting_allocator::stats stats;
+    lake::basic_string<counting_allocator> str("0123456789abcdefghijklmn", counting_allocator { &stats });
+    EXPECT_FALSE(str.is_inline());
+    EXPECT_EQ(stats.allocations, 1);
+    EXPECT_EQ(str.size(), 24);
+    EXPECT_GE(str.capacity(), 24);
+    EXPECT_STREQ(str.c_str(), "0123456789abcdefghijklmn");
+
+    str.clear();
+    EXPECT_TRUE(str.is_inline());
+    EXPECT_TRUE(str.empty());
+    EXPECT_EQ(stats.allocations, 0);
+}
+
+TEST(String, Append)
+{
+    lake::string str;
+    lake::vector<char> expected;
+    for (size_t i = 0; i < 200; ++i) {
+        char c = static_cast<char>('a' + i % 26);
+        if (i % 2 == 0) {
+            str.append(c);
+        } else {
+            str += lake::string_view(&c, 1);
+        }
+        expected.push_back(c);
+
+        EXPECT_EQ(str.size(), i + 1);
+        EXPECT_EQ(str.is_inline(), i < lake::string::inline_capacity);
+        EXPECT_EQ(str.view(), lake::string_view(expected.data(), expected.size()));
+        EXPECT_EQ(str.c_str()[str.size()], '\0');
+    }
+}
+
+TEST(String, AppendSelf)
+{
+    lake::string str = "abc";
+    for (size_t i = 0; i < 5; ++i) {
+        str.append(str.view());
+    }
+    EXPECT_EQ(str.size(), 3 * 32);
+    for (size_t i = 0; i < str.size(); ++i) {
+        EXPECT_EQ(str[i], "abc"[i % 3]);
+    }
+
+    // Appending a part of the string itself.
+    str.append(str.view().subview(1, 2));
+    EXPECT_TRUE(str.view().ends_with("abcbc"));
+}
+
+TEST(String, Reserve)
+{
+    counting_allocator::stats stats;
+    lake::basic_string<counting_allocator> str(counting_allocator { &stats });
+    str.reserve(100);
+    EXPECT_EQ(stats.allocations, 1);
+    EXPECT_GE(str.capacity(), 100);
+    EXPECT_TRUE(str.empty());
+    EXPECT_STREQ(str.c_str(), "");
+
+    for (size_t i = 0; i < 100; ++i) {
+        str.append('x');
+    }
+    EXPECT_EQ(stats.allocations, 1);
+    EXPECT_EQ(str.size(), 100);
+}
+
+TEST(String, Copy)
+{
+    for (char const* value : { "short", "a string which does not fit inline" }) {
+        lake::string str = value;
+        lake::string copy(str);
+        EXPECT_EQ(copy, str);
+        EXPECT_NE(copy.data(), str.data());
+
+        lake::string assigned = "foo";
+        assigned = str;
+        EXPECT_EQ(assigned, value);
+
+        // Assignment from a part of the string itself.
+        assigned = assigned.view().subview(1, 3);
+        EXPECT_EQ(assigned, lake::string_view(value + 1, 3));
+    }
+}
+
+TEST(String, MoveDoesNotAllocate)
+{
+    counting_allocator::stats stats;
+    for (char const* value : { "short", "a string which does not fit inline" }) {
+        lake::basic_string<counting_allocator> str(value, counting_allocator { &stats });
+        auto allocations = stats.allocations;
+        auto const* heap_data = str.is_inline() ? nullptr : str.data();
+
+        lake::basic_string<counting_allocator> moved(move(str));
+        EXPECT_EQ(moved, value);
+        EXPECT_TRUE(str.empty());
+        EXPECT_TRUE(str.is_inline());
+        if (heap_data) {
+            EXPECT_EQ(moved.data(), heap_data);
+        }
+
+        lake::basic_string<counting_allocator> assigned(counting_allocator { &stats });
+        assigned = move(moved);
+        EXPECT_EQ(assigned, value);
+        EXPECT_TRUE(moved.empty());
+        EXPECT_EQ(stats.allocations, allocations);
+    }
+    EXPECT_EQ(stats.allocations, 0);
+}
+
+TEST(String, ToStringView)
+{
+    lake::string str = "a string which does not fit inline";
+    lake::string_view view = str;
+    EXPECT_EQ(view.data(), str.data());
+    EXPECT_EQ(view.size(), str.size());
+    EXPECT_TRUE(str.view().contains("fit"));
+}
+
+TEST(String, Hash)
+{
+    auto hash_of = [](auto const& value) {
+        lake::hash_state hs;
+        hs.hash(value);
+        return hs.value();
+    };
+    lake::string str = "a string which does not fit inline";
+    EXPECT_EQ(hash_of(str), hash_of(str.view()));
+    EXPECT_NE(hash_of(str), hash_of(lake::string("a string")));
+}
+
+TEST(String, InVector)
+{
+    // Strings are relocated with memcpy when the vector grows.
+    lake::vector<lake::string> vec;
+    for (size_t i = 0; i < 100; ++i) {
+        lake::string str = i % 2 ? "a string which does not fit inline" : "short";
+        str.append(static_cast<char>('0' + i % 10));
+        vec.push_back(move(str));
+    }
+    for (size_t i = 0; i < 100; ++i) {
+        EXPECT_TRUE(vec[i].view().starts_with(i % 2 ? "a string" : "short"));
+        EXPECT_EQ(vec[i].back(), static_cast<char>('0' + i % 10));
+    }
+}
@@ -112,3 +112,153 @@ TEST(StringView, EndsWidth)
     EXPECT_FALSE(sv.ends_with("aaa foo bar baz"_sv));
     EXPECT_FALSE(sv.ends_with("baz\0"_sv));
 }
+
+TEST(StringView, ContainsConstexpr)
+{
+    static_assert("foo bar baz"_sv.contains("bar"_sv));
+    static_assert(!"foo bar baz"_sv.contains("bax"_sv));
+    static_assert("foo bar baz"_sv.contains('z'));
+    static_assert("foo bar baz"_sv.count('a') == 2);
+}
+
+TEST(StringView, FindChar)
+{
+    auto sv = "foo bar baz"_sv;
+
+    EXPECT_EQ(sv.find('f').value(), 0ul);
+    EXPECT_EQ(sv.find('o').value(), 1ul);
+    EXPECT_EQ(sv.find('z').value(), 10ul);
+    EXPECT_FALSE(sv.find('x').has_value());
+    EXPECT_FALSE(""_sv.find('x').has_value());
+
+    EXPECT_EQ(sv.rfind('f').value(), 0ul);
+    EXPECT_EQ(sv.rfind('o').value(), 2ul);
+    EXPECT_EQ(sv.rfind('a').value(), 9ul);
+    EXPECT_FALSE(sv.rfind('x').has_value());
+    EXPECT_FALSE(""_sv.rfind('x').has_value());
+}
+
+TEST(StringView, FindStringView)
+{
+    auto sv = "foo bar baz"_sv;
+
+    EXPECT_EQ(sv.find("foo"_sv).value(), 0ul);
+    EXPECT_EQ(sv.find("ba"_sv).value(), 4ul);
+    EXPECT_EQ(sv.find("baz"_sv).value(), 8ul);
+    EXPECT_EQ(sv.find(sv).value(), 0ul);
+    EXPECT_EQ(sv.find(""_sv).value(), 0ul);
+    EXPECT_FALSE(sv.find("bax"_sv).has_value());
+    EXPECT_FALSE(sv.find("foo bar baz!"_sv).has_value());
+
+    EXPECT_EQ(sv.rfind("foo"_sv).value(), 0ul);
+    EXPECT_EQ(sv.rfind("ba"_sv).value(), 8ul);
+    EXPECT_EQ(sv.rfind(sv).value(), 0ul);
+    EXPECT_EQ(sv.rfind(""_sv).value(), 11ul);
+    EXPECT_FALSE(sv.rfind("bax"_sv).has_value());
+}
+
+TEST(StringView, FindLong)
+{
+    // Long enough to use the SIMD code paths, with matches at every position relative to the blocks.
+    char buffer[300];
+    for (size_t i = 0; i < sizeof(buffer); ++i) {
+        buffer[i] = static_cast<char>('a' + i % 7);
+    }
+    lake::string_view haystack(buffer, sizeof(buffer));
+
+    for (size_t needle_size : { 1, 2, 3, 17, 40 }) {
+        for (size_t position = 0; position + needle_size <= haystack.size(); ++position) {
+            // Insert a needle containing 'x', which does not occur anywhere else. Its first and last bytes do occur
+            // elsewhere (except for the shortest needles), so that there are many false candidates.
+            char needle_buffer[40];
+            for (size_t i = 0; i < needle_size; ++i) {
+                needle_buffer[i] = 'x';
+            }
+            if (needle_size >= 2) {
+                needle_buffer[0] = 'a';
+            }
+            if (needle_size >= 3) {
+                needle_buffer[needle_size - 1] = 'b';
+            }
+            lake::string_view needle(needle_buffer, needle_size);
+
+            char original[40];
+            __builtin_memcpy(original, buffer + position, needle_size);
+            __builtin_memcpy(buffer + position, needle_buffer, needle_size);
+
+            EXPECT_EQ(haystack.find(needle).value(), position) << needle_size << " at " << position;
+            EXPECT_EQ(haystack.rfind(needle).value(), position) << needle_size << " at " << position;
+            EXPECT_EQ(haystack.count(needle), 1ul) << needle_size << " at " << position;
+
+            __builtin_memcpy(buffer + position, original, needle_size);
+        }
+    }
+}
+
+TEST(StringView, FindFirstOf)
+{
+    auto sv = "key = value; other"_sv;
+
+    EXPECT_EQ(sv.find_first_of(" =;"_sv).value(), 3ul);
+    EXPECT_EQ(sv.find_first_of(";"_sv).value(), 11ul);
+    EXPECT_EQ(sv.find_first_of("rv"_sv).value(), 6ul);
+    EXPECT_FALSE(sv.find_first_of("xz"_sv).has_value());
+    EXPECT_FALSE(sv.find_first_of(""_sv).has_value());
+}
+
+TEST(StringView, FindLastNotOf)
+{
+    auto sv = "value \t\n"_sv;
+
+    EXPECT_EQ(sv.find_last_not_of(" \t\n"_sv).value(), 4ul);
+    EXPECT_EQ(sv.find_last_not_of(""_sv).value(), 7ul);
+    EXPECT_FALSE(sv.find_last_not_of("value \t\n"_sv).has_value());
+    EXPECT_FALSE(""_sv.find_last_not_of(" "_sv).has_value());
+}
+
+TEST(StringView, FindOfLong)
+{
+    // Long enough to use the SIMD code paths, with the character to find at every position relative to the blocks. The
+    // large set takes a different path than the small one without SSSE3, and includes bytes with the high bit set.
+    char buffer[300];
+    for (size_t i = 0; i < sizeof(buffer); ++i) {
+        buffer[i] = static_cast<char>('a' + i % 7);
+    }
+    lake::string_view haystack(buffer, sizeof(buffer));
+    auto small_set = "xyz"_sv;
+    auto large_set = "0123456789=;:,xyz\x80\xff"_sv;
+    auto letters = "abcdefg"_sv;
+
+    for (size_t position = 0; position < haystack.size(); ++position) {
+        auto original = buffer[position];
+        for (char c : { 'x', '\xff' }) {
+            buffer[position] = c;
+            if (c == 'x') {
+                EXPECT_EQ(haystack.find_first_of(small_set).value(), position) << position;
+            }
+            EXPECT_EQ(haystack.find_first_of(large_set).value(), position) << position;
+            EXPECT_EQ(haystack.find_last_not_of(letters).value(), position) << position;
+        }
+        buffer[position] = original;
+    }
+    EXPECT_FALSE(haystack.find_first_of(large_set).has_value());
+    EXPECT_FALSE(haystack.find_last_not_of(letters).has_value());
+    EXPECT_EQ(haystack.find_last_not_of("abcdef"_sv).value(), 293ul);
+}
+
+TEST(StringView, Count)
+{
+    EXPECT_EQ("foo bar baz"_sv.count('a'), 2ul);
+    EXPECT_EQ("foo bar baz"_sv.count('x'), 0ul);
+    EXPECT_EQ(""_sv.count('x'), 0ul);
+
+    EXPECT_EQ("foo bar baz"_sv.count("ba"_sv), 2ul);
+    EXPECT_EQ("aaaa"_sv.count("aa"_sv), 2ul); // non-overlapping
+    EXPECT_EQ("aaaa"_sv.count("b"_sv), 0ul);
+
+    char lines[1000];
+    for (size_t i = 0; i < sizeof(lines); ++i) {
+        lines[i] = i % 10 == 9 ? '\n' : 'x';
+    }
+    EXPECT_EQ(lake::string_view(lines, sizeof(lines)).count('\n'), 100ul);
+}
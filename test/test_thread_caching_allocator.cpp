@@ -0,0 +1,157 @@
+/*
+ * SPDX-FileCopyrightText: 2023 Max Wipfli <mail@maxwipfli.ch>
+ * SPDX-LicenseIdentifier: MIT
+ */
+
+#include "utils.hpp"
+#include <gtest/gtest.h>
+#include <lake/fixed_array.hpp>
+#include <lake/thread_caching_allocator.hpp>
+#include <lake/vector.hpp>
+#include <pthread.h>
+
+using allocator = lake::thread_caching_allocator;
+
+static_assert(sizeof(lake::vector<u64, allocator>) == sizeof(lake::vector<u64>));
+
+TEST(ThreadCachingAllocator, SizeClasses)
+{
+    for (size_t size = 1; size <= allocator::max_small_size; ++size) {
+        auto index = allocator::class_index(size);
+        ASSERT_LT(index, allocator::class_count);
+        // The size class is the smallest one that fits.
+        ASSERT_GE(allocator::class_size(index), size);
+        if (index > 0) {
+            ASSERT_LT(allocator::class_size(index - 1), size);
+        }
+        // Blocks are 16-byte aligned, and at most 25% larger than needed.
+        ASSERT_EQ(allocator::class_size(index) % 16, 0);
+        if (size > 128) {
+            ASSERT_LE(allocator::class_size(index), size + size / 4);
+        }
+    }
+}
+
+TEST(ThreadCachingAllocator, AllocateDeallocate)
+{
+    allocator alloc;
+    void* blocks[1000];
+    for (size_t i = 0; i < 1000; ++i) {
+        auto size = 1 + i * 7 % 300;
+        blocks[i] = alloc.allocate(size, 8);
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(blocks[i]) % 16, 0);
+        __builtin_memset(blocks[i], static_cast<int>(i), size);
+    }
+    for (size_t i = 0; i < 1000; ++i) {
+        auto size = 1 + i * 7 % 300;
+        auto* bytes = static_cast<u8*>(blocks[i]);
+        for (size_t j = 0; j < size; ++j) {
+            ASSERT_EQ(bytes[j], static_cast<u8>(i)) << "block " << i;
+        }
+        alloc.deallocate(blocks[i], size, 8);
+    }
+
+    // The most recently freed block of a size class is reused first.
+    auto* first = alloc.allocate(100, 8);
+    alloc.deallocate(first, 100, 8);
+    auto* second = alloc.allocate(112, 16);
+    EXPECT_EQ(first, second);
+    alloc.deallocate(second, 112, 16);
+}
+
+TEST(ThreadCachingAllocator, LargeAndOverAligned)
+{
+    allocator alloc;
+    auto* large = alloc.allocate(allocator::max_small_size + 1, 8);
+    __builtin_memset(large, 0, allocator::max_small_size + 1);
+    alloc.deallocate(large, allocator::max_small_size + 1, 8);
+
+    auto* aligned = alloc.allocate(32, 64);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(aligned) % 64, 0);
+    alloc.deallocate(aligned, 32, 64);
+}
+
+TEST(ThreadCachingAllocator, Containers)
+{
+    lake::vector<u64, allocator> vec;
+    for (u64 i = 0; i < 10000; ++i) {
+        vec.push_back(i);
+    }
+    for (u64 i = 0; i < 10000; ++i) {
+        EXPECT_EQ(vec[i], i);
+    }
+
+    lake::fixed_array<u32, allocator> array { 1, 2, 3 };
+    EXPECT_EQ(array[2], 3);
+}
+
+static void* churn(void* arg)
+{
+    auto seed = reinterpret_cast<uintptr_t>(arg);
+    allocator alloc;
+    void* blocks[64] = {};
+    size_t sizes[64] = {};
+    for (size_t i = 0; i < 200000; ++i) {
+        seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+        auto slot = (seed >> 40) % 64;
+        if (blocks[slot]) {
+            // Check that no other thread wrote to the block in the meantime.
+            EXPECT_EQ(*static_cast<size_t*>(blocks[slot]), sizes[slot]);
+            alloc.deallocate(blocks[slot], sizes[slot], 8);
+            blocks[slot] = nullptr;
+        } else {
+            sizes[slot] = 8 + (seed >> 20) % 2000;
+            blocks[slot] = alloc.allocate(sizes[slot], 8);
+            *static_cast<size_t*>(blocks[slot]) = sizes[slot];
+        }
+    }
+    for (size_t slot = 0; slot < 64; ++slot) {
+        if (blocks[slot]) {
+            alloc.deallocate(blocks[slot], sizes[slot], 8);
+        }
+    }
+    return nullptr;
+}
+
+TEST(ThreadCachingAllocator, Threads)
+{
+    pthread_t threads[4];
+    for (size_t i = 0; i < 4; ++i) {
+        pthread_create(&threads[i], nullptr, churn, reinterpret_cast<void*>(i + 1));
+    }
+    for (auto& thread : threads) {
+        pthread_join(thread, nullptr);
+    }
+}
+
+static void* allocate_vectors(void* arg)
+{
+    auto& vectors = *static_cast<lake::vector<lake::vector<u32, allocator>>*>(arg);
+    for (u32 i = 0; i < 1000; ++i) {
+        lake::vector<u32, allocator> vec;
+        for (u32 j = 0; j < i % 50; ++j) {
+            vec.push_back(j);
+        }
+        vectors.push_back(lake::move(vec));
+    }
+    return nullptr;
+}
+
+TEST(ThreadCachingAllocator, FreeOnOtherThread)
+{
+    // Blocks allocated by a thread which has exited are freed (and reused) by another one.
+    lake::vector<lake::vector<u32, allocator>> vectors;
+    pthread_t thread;
+    pthread_create(&thread, nullptr, allocate_vectors, &vectors);
+    pthread_join(thread, nullptr);
+
+    for (u32 i = 0; i < 1000; ++i) {
+        ASSERT_EQ(vectors[i].size(), i % 50);
+        for (u32 j = 0; j < i % 50; ++j) {
+            ASSERT_EQ(vectors[i][j], j);
+        }
+    }
+    vectors.clear();
+    allocate_vectors(&vectors);
+    EXPECT_EQ(vectors.size(), 1000);
+}
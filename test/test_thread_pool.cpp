@@ -0,0 +1,175 @@
+/*
+ * SPDX-FileCopyrightText: 2023 Max Wipfli <mail@maxwipfli.ch>
+ * SPDX-LicenseIdentifier: MIT
+ */
+
+#include <gtest/gtest.h>
+#include <lake/thread_pool.hpp>
+#include <lake/vector.hpp>
+
+TEST(ThreadPool, Create)
+{
+    lake::thread_pool pool(4);
+    EXPECT_EQ(pool.size(), 4);
+    EXPECT_GE(lake::thread_pool::hardware_concurrency(), 1);
+}
+
+TEST(ThreadPool, Run)
+{
+    lake::thread_pool pool(2);
+    int value = 0;
+    pool.run([&] { value = 42; });
+    EXPECT_EQ(value, 42);
+}
+
+static u64 fibonacci(lake::thread_pool& pool, u64 n)
+{
+    if (n < 2) {
+        return n;
+    }
+    u64 a, b;
+    pool.join([&] { a = fibonacci(pool, n - 1); }, [&] { b = fibonacci(pool, n - 2); });
+    return a + b;
+}
+
+TEST(ThreadPool, NestedJoin)
+{
+    lake::thread_pool pool(4);
+    EXPECT_EQ(fibonacci(pool, 25), 75025);
+}
+
+TEST(ThreadPool, ParallelFor)
+{
+    lake::thread_pool pool(4);
+    lake::vector<u64> values;
+    values.resize(100000);
+    pool.parallel_for(lake::span<u64>(values), 1000, [](lake::span<u64> chunk) {
+        EXPECT_LE(chunk.size(), 1000);
+        for (auto& value : chunk) {
+            value += 1;
+        }
+    });
+    for (size_t i = 0; i < values.size(); ++i) {
+        ASSERT_EQ(values[i], 1) << "index " << i;
+    }
+}
+
+TEST(ThreadPool, ParallelForChunks)
+{
+    lake::thread_pool pool(3);
+    lake::vector<u32> values;
+    values.resize(1000);
+    // Every element is visited exactly once, through a chunk covering its index.
+    pool.parallel_for(lake::span<u32>(values), 7, [&](lake::span<u32> chunk) {
+        auto offset = static_cast<u32>(chunk.data() - values.data());
+        for (u32 i = 0; i < chunk.size(); ++i) {
+            chunk[i] += offset + i;
+        }
+    });
+    for (u32 i = 0; i < values.size(); ++i) {
+        ASSERT_EQ(values[i], i);
+    }
+}
+
+TEST(ThreadPool, ParallelReduce)
+{
+    lake::thread_pool pool(4);
+    lake::vector<u64> values;
+    values.resize(12345);
+    for (size_t i = 0; i < values.size(); ++i) {
+        values[i] = i;
+    }
+    auto sum = pool.parallel_reduce(
+        lake::span<u64 const>(values.data(), values.size()), 100, u64 { 0 },
+        [](lake::span<u64 const> chunk) {
+            u64 result = 0;
+            for (auto value : chunk) {
+                result += value;
+            }
+            return result;
+        },
+        [](u64 a, u64 b) { return a + b; });
+    EXPECT_EQ(sum, 12345ull * 12344 / 2);
+
+    auto empty = pool.parallel_reduce(
+        lake::span<u64 const>(), 100, u64 { 7 }, [](lake::span<u64 const>) { return u64 { 0 }; },
+        [](u64 a, u64 b) { return a + b; });
+    EXPECT_EQ(empty, 7);
+}
+
+TEST(ThreadPool, ParallelReducePreservesOrder)
+{
+    lake::thread_pool pool(4);
+    lake::vector<u8> digits;
+    digits.resize(500);
+    for (size_t i = 0; i < digits.size(); ++i) {
+        digits[i] = i % 10;
+    }
+    // The first and last element of the concatenation of all chunks, which is not commutative.
+    struct ends {
+        int first;
+        int last;
+    };
+    auto result = pool.parallel_reduce(
+        lake::span<u8>(digits), 3, ends { -1, -1 },
+        [](lake::span<u8> chunk) { return ends { chunk[0], chunk[chunk.size() - 1] }; },
+        [](ends a, ends b) { return ends { a.first, b.last }; });
+    EXPECT_EQ(result.first, 0);
+    EXPECT_EQ(result.last, 9);
+}
+
+static void* run_parallel_for(void* argument)
+{
+    auto& pool = *static_cast<lake::thread_pool*>(argument);
+    lake::vector<u32> values;
+    values.resize(10000);
+    for (size_t round = 0; round < 20; ++round) {
+        pool.parallel_for(lake::span<u32>(values), 64, [](lake::span<u32> chunk) {
+            for (auto& value : chunk) {
+                value++;
+            }
+        });
+    }
+    for (auto value : values) {
+        EXPECT_EQ(value, 20);
+    }
+    return nullptr;
+}
+
+TEST(ThreadPool, ConcurrentCallers)
+{
+    lake::thread_pool pool(4);
+    pthread_t threads[4];
+    for (auto& thread : threads) {
+        pthread_create(&thread, nullptr, run_parallel_for, &pool);
+    }
+    for (auto& thread : threads) {
+        pthread_join(thread, nullptr);
+    }
+}
+
+TEST(ThreadPool, Global)
+{
+    auto& pool = lake::thread_pool::global();
+    EXPECT_EQ(&pool, &lake::thread_pool::global());
+    EXPECT_EQ(pool.size(), lake::thread_pool::hardware_concurrency());
+
+    lake::vector<int> values;
+    values.resize(1000);
+    lake::parallel_for(lake::span<int>(values), 10, [](lake::span<int> chunk) {
+        for (auto& value : chunk) {
+            value = 3;
+        }
+    });
+    auto sum = lake::parallel_reduce(
+        lake::span<int>(values), 10, 0,
+        [](lake::span<int> chunk) {
+            int result = 0;
+            for (auto value : chunk) {
+                result += value;
+            }
+            return result;
+        },
+        [](int a, int b) { return a + b; });
+    EXPECT_EQ(sum, 3000);
+}
@@ -102,3 +102,45 @@ TEST(UniquePtr, MoveAssignmentOperator)
     }
     EXPECT_EQ(destruct_count, 1);
 }
+
+TEST(UniquePtr, Allocator)
+{
+    counting_allocator::stats stats;
+    int destruct_count = 0;
+    {
+        auto unique_ptr = lake::allocate_unique<destruction_counter>(counting_allocator(&stats), &destruct_count);
+        EXPECT_TRUE(unique_ptr);
+        EXPECT_EQ(stats.allocations, 1);
+        EXPECT_EQ(stats.bytes, sizeof(destruction_counter));
+
+        unique_ptr.emplace(&destruct_count);
+        EXPECT_EQ(destruct_count, 1);
+        EXPECT_EQ(stats.allocations, 1);
+    }
+    EXPECT_EQ(destruct_count, 2);
+    EXPECT_EQ(stats.allocations, 0);
+}
+
+TEST(UniquePtr, ConstructionForwards)
+{
+    copy_counter::counts counts;
+    copy_counter counter(&counts);
+
+    auto ptr = lake::make_unique<copy_counter>(counter);
+    EXPECT_EQ(counts.copies, 1);
+    EXPECT_EQ(counts.moves, 0);
+    ptr.emplace(lake::move(counter));
+    EXPECT_EQ(counts.copies, 1);
+    EXPECT_EQ(counts.moves, 1);
+
+    int value = 0;
+    auto holder = lake::make_unique<reference_holder>(value);
+    EXPECT_EQ(&holder->reference(), &value);
+    holder.emplace(value);
+    EXPECT_EQ(&holder->reference(), &value);
+
+    auto inner = lake::make_unique<int>(42);
+    auto outer = lake::make_unique<lake::unique_ptr<int>>(lake::move(inner));
+    EXPECT_FALSE(inner);
+    EXPECT_EQ(*(*outer)->ptr(), 42);
+}
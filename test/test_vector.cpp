@@ -6,6 +6,7 @@
 #include "utils.hpp"
 #include <gtest/gtest.h>
 #include <lake/array.hpp>
+#include <lake/unique_ptr.hpp>
 #include <lake/vector.hpp>
 
 TEST(Vector, Empty)
@@ -130,3 +131,264 @@ TEST(Vector, Equality)
     EXPECT_EQ(vector, another_vector);
     EXPECT_EQ(vector, array.span());
 }
+
+static_assert(lake::is_trivially_relocatable_v<u64>);
+static_assert(lake::is_trivially_relocatable_v<lake::unique_ptr<destruction_counter>>);
+static_assert(lake::is_trivially_relocatable_v<lake::vector<destruction_counter>>);
+static_assert(!lake::is_trivially_relocatable_v<destruction_counter>);
+
+TEST(Vector, TriviallyRelocatableGrowth)
+{
+    int destruction_count = 0;
+    {
+        lake::vector<lake::unique_ptr<destruction_counter>> vec;
+        for (int i = 0; i < 100; ++i) {
+            vec.push_back(lake::make_unique<destruction_counter>(&destruction_count));
+        }
+        // Relocating the elements on growth must neither destroy nor duplicate the pointees.
+        EXPECT_EQ(destruction_count, 0);
+        EXPECT_EQ(vec.size(), 100);
+        for (auto const& ptr : vec) {
+            EXPECT_TRUE(ptr);
+        }
+    }
+    EXPECT_EQ(destruction_count, 100);
+
+    lake::vector<u64> vec;
+    for (u64 i = 0; i < 1000; ++i) {
+        vec.push_back(i);
+    }
+    for (u64 i = 0; i < 1000; ++i) {
+        EXPECT_EQ(vec[i], i);
+    }
+}
+
+TEST(Vector, Allocator)
+{
+    counting_allocator::stats stats;
+    {
+        auto allocator = counting_allocator(&stats);
+        lake::vector<u64, counting_allocator> vec(allocator);
+        EXPECT_EQ(stats.allocations, 0);
+        for (u64 i = 0; i < 100; ++i) {
+            vec.push_back(i);
+        }
+        EXPECT_EQ(stats.allocations, 1);
+        EXPECT_EQ(stats.bytes, vec.capacity() * sizeof(u64));
+
+        auto moved_vec = lake::move(vec);
+        EXPECT_EQ(stats.allocations, 1);
+        EXPECT_EQ(moved_vec.size(), 100);
+        EXPECT_EQ(moved_vec[99], 99);
+    }
+    EXPECT_EQ(stats.allocations, 0);
+    EXPECT_EQ(stats.bytes, 0);
+
+    // The default allocator is stateless and does not take up any space.
+    static_assert(sizeof(lake::vector<u64>) == 3 * sizeof(void*));
+}
+
+TEST(Vector, EmplaceBackForwards)
+{
+    copy_counter::counts counts;
+    copy_counter counter(&counts);
+    lake::vector<copy_counter> vec;
+    vec.reserve(4);
+
+    // Arguments are forwarded to the constructor, so lvalues are copied and rvalues are moved exactly once.
+    vec.emplace_back(counter);
+    EXPECT_EQ(counts.copies, 1);
+    EXPECT_EQ(counts.moves, 0);
+    vec.emplace_back(lake::move(counter));
+    EXPECT_EQ(counts.copies, 1);
+    EXPECT_EQ(counts.moves, 1);
+    vec.emplace_back(&counts);
+    EXPECT_EQ(counts.copies, 1);
+    EXPECT_EQ(counts.moves, 1);
+
+    // Move-only arguments and references work as well.
+    int destruct_count = 0;
+    lake::vector<lake::unique_ptr<destruction_counter>> pointers;
+    auto ptr = lake::make_unique<destruction_counter>(&destruct_count);
+    pointers.emplace_back(lake::move(ptr));
+    EXPECT_FALSE(ptr);
+
+    int value = 0;
+    lake::vector<reference_holder> references;
+    references.emplace_back(value);
+    EXPECT_EQ(&references[0].reference(), &value);
+}
+
+TEST(Vector, InitializerList)
+{
+    lake::vector<int> vec = { 1, 2, 3 };
+    EXPECT_EQ(vec.size(), 3);
+    EXPECT_EQ(vec[2], 3);
+
+    vec = { 4, 5 };
+    EXPECT_EQ(vec, lake::span<int const>({ 4, 5 }));
+}
+
+TEST(Vector, AssignShorterSpan)
+{
+    int destruction_count = 0;
+    auto counter = destruction_counter(&destruction_count);
+    auto vec = lake::vector<destruction_counter>::filled(4, counter);
+    auto other = lake::vector<destruction_counter>::filled(1, counter);
+
+    // The allocation is reused, and the elements beyond the new size are destroyed.
+    auto const* data = vec.data();
+    vec = other.span();
+    EXPECT_EQ(vec.size(), 1);
+    EXPECT_EQ(vec.data(), data);
+    EXPECT_EQ(destruction_count, 3);
+}
+
+// Integers with a non-trivial copy constructor, which are therefore not trivially relocatable.
+class boxed_int {
+public:
+    boxed_int(int value) // NOLINT(google-explicit-constructor)
+        : m_value(value)
+    {
+    }
+    boxed_int(boxed_int const& other)
+        : m_value(other.m_value)
+    {
+    }
+    boxed_int& operator=(boxed_int const&) = default;
+
+    bool operator==(boxed_int const&) const = default;
+
+private:
+    int m_value;
+};
+
+static_assert(!lake::is_trivially_relocatable_v<boxed_int>);
+
+template <typename T>
+class VectorBulk : public ::testing::Test {
+};
+
+using BulkTypes = ::testing::Types<int, boxed_int>;
+TYPED_TEST_SUITE(VectorBulk, BulkTypes);
+
+TYPED_TEST(VectorBulk, Append)
+{
+    lake::vector<TypeParam> vec;
+    lake::array<TypeParam, 3> values = { 1, 2, 3 };
+    vec.append(values.span());
+    vec.append(lake::span<TypeParam>());
+    vec.append(values.span().subspan(1, 2));
+    EXPECT_EQ(vec, (lake::vector<TypeParam> { 1, 2, 3, 2, 3 }));
+
+    // Appending the vector to itself, which requires reallocation.
+    vec.shrink_to_fit();
+    vec.append(vec.span());
+    EXPECT_EQ(vec, (lake::vector<TypeParam> { 1, 2, 3, 2, 3, 1, 2, 3, 2, 3 }));
+}
+
+TYPED_TEST(VectorBulk, Insert)
+{
+    lake::vector<TypeParam> vec;
+    lake::array<TypeParam, 2> values = { 8, 9 };
+    vec.insert(0, values.span());
+    EXPECT_EQ(vec, (lake::vector<TypeParam> { 8, 9 }));
+    vec.insert(1, lake::vector<TypeParam> { 1, 2, 3 }.span());
+    EXPECT_EQ(vec, (lake::vector<TypeParam> { 8, 1, 2, 3, 9 }));
+    vec.insert(5, values.span());
+    vec.insert(0, values.span().subspan(1, 1));
+    EXPECT_EQ(vec, (lake::vector<TypeParam> { 9, 8, 1, 2, 3, 9, 8, 9 }));
+}
+
+TYPED_TEST(VectorBulk, Erase)
+{
+    lake::vector<TypeParam> vec = { 0, 1, 2, 3, 4, 5 };
+    vec.erase(1, 3);
+    EXPECT_EQ(vec, (lake::vector<TypeParam> { 0, 3, 4, 5 }));
+    vec.erase(2, 2);
+    EXPECT_EQ(vec.size(), 4);
+    vec.erase(2, 4);
+    EXPECT_EQ(vec, (lake::vector<TypeParam> { 0, 3 }));
+    vec.erase(0, 2);
+    EXPECT_TRUE(vec.empty());
+
+    EXPECT_DEATH(vec.erase(0, 1), "");
+}
+
+TEST(Vector, EraseDestroys)
+{
+    int destruction_count = 0;
+    {
+        lake::vector<destruction_counter> vec;
+        for (int i = 0; i < 5; ++i) {
+            vec.emplace_back(&destruction_count);
+        }
+        vec.erase(1, 3);
+        EXPECT_EQ(destruction_count, 2);
+        EXPECT_EQ(vec.size(), 3);
+    }
+    EXPECT_EQ(destruction_count, 5);
+}
+
+TEST(Vector, Resize)
+{
+    lake::vector<u64> vec;
+    vec.resize(100);
+    EXPECT_EQ(vec.size(), 100);
+    for (auto value : vec) {
+        EXPECT_EQ(value, 0);
+    }
+    vec[99] = 42;
+    vec.resize(1000);
+    EXPECT_EQ(vec[99], 42);
+    EXPECT_EQ(vec[999], 0);
+
+    int destruction_count = 0;
+    lake::vector<lake::unique_ptr<destruction_counter>> pointers;
+    pointers.resize(3);
+    EXPECT_FALSE(pointers[2]);
+    pointers[1] = lake::make_unique<destruction_counter>(&destruction_count);
+    pointers.resize(1);
+    EXPECT_EQ(destruction_count, 1);
+}
+
+TEST(Vector, ResizeForOverwrite)
+{
+    counting_allocator::stats stats;
+    auto allocator = counting_allocator(&stats);
+    lake::vector<u8, counting_allocator> vec(allocator);
+    vec.resize_for_overwrite(1000);
+    EXPECT_EQ(vec.size(), 1000);
+    EXPECT_EQ(stats.allocations, 1);
+    for (size_t i = 0; i < vec.size(); ++i) {
+        vec[i] = static_cast<u8>(i);
+    }
+    vec.resize_for_overwrite(10);
+    EXPECT_EQ(vec.size(), 10);
+    EXPECT_EQ(vec[9], 9);
+}
+
+TEST(Vector, ShrinkToFit)
+{
+    counting_allocator::stats stats;
+    auto allocator = counting_allocator(&stats);
+    lake::vector<u64, counting_allocator> vec(allocator);
+    vec.reserve(100);
+    lake::array<u64, 3> values = { 1, 2, 3 };
+    vec.append(values.span());
+    vec.shrink_to_fit();
+    EXPECT_EQ(vec.capacity(), 3);
+    EXPECT_EQ(stats.bytes, 3 * sizeof(u64));
+    EXPECT_EQ(vec, (lake::vector<u64> { 1, 2, 3 }));
+
+    vec.clear();
+    vec.shrink_to_fit();
+    EXPECT_EQ(vec.capacity(), 0);
+    EXPECT_EQ(stats.allocations, 0);
+
+    // Growth after shrinking is geometric again.
+    for (u64 i = 0; i < 5; ++i) {
+        vec.push_back(i);
+    }
+    EXPECT_EQ(vec.capacity(), 8);
+}
@@ -5,6 +5,7 @@
 
 #pragma once
 
+#include <lake/allocator.hpp>
 #include <lake/types.hpp>
 
 class non_copyable {
@@ -89,8 +90,105 @@ private:
     int* m_count_ptr;
 };
 
+// Counts how often it is copied and moved, to check that values are constructed in place. The payload makes copies
+// expensive, like those of large objects in real code.
+class copy_counter {
+public:
+    struct counts {
+        size_t copies { 0 };
+        size_t moves { 0 };
+    };
+
+    explicit copy_counter(counts* counts)
+        : m_counts(counts)
+    {
+    }
+
+    copy_counter(copy_counter const& other)
+        : m_counts(other.m_counts)
+    {
+        m_counts->copies++;
+    }
+    copy_counter& operator=(copy_counter const& other)
+    {
+        m_counts = other.m_counts;
+        m_counts->copies++;
+        return *this;
+    }
+
+    copy_counter(copy_counter&& other) noexcept
+        : m_counts(other.m_counts)
+    {
+        m_counts->moves++;
+    }
+    copy_counter& operator=(copy_counter&& other) noexcept
+    {
+        m_counts = other.m_counts;
+        m_counts->moves++;
+        return *this;
+    }
+
+private:
+    counts* m_counts;
+    u8 m_payload[1024] {};
+};
+
+// Holds a reference to its constructor argument, which only works if the argument is forwarded as a reference.
+class reference_holder {
+public:
+    explicit reference_holder(int& reference)
+        : m_reference(reference)
+    {
+    }
+
+    [[nodiscard]] int& reference() const { return m_reference; }
+
+private:
+    int& m_reference;
+};
+
+// A stateful allocator which keeps track of the number of live allocations and bytes.
+class counting_allocator {
+public:
+    struct stats {
+        size_t allocations { 0 };
+        size_t bytes { 0 };
+    };
+
+    explicit counting_allocator(stats* stats)
+        : m_stats(stats)
+    {
+    }
+
+    void* allocate(size_t size, size_t alignment)
+    {
+        m_stats->allocations++;
+        m_stats->bytes += size;
+        return lake::default_allocator {}.allocate(size, alignment);
+    }
+
+    void deallocate(void* ptr, size_t size, size_t alignment)
+    {
+        m_stats->allocations--;
+        m_stats->bytes -= size;
+        lake::default_allocator {}.deallocate(ptr, size, alignment);
+    }
+
+private:
+    stats* m_stats;
+};
+
 #define TEST_TODO(test_suite_name, test_name) \
     TEST(test_suite_name, test_name)          \
     {                                         \
         GTEST_SKIP_("TODO");                  \
     }
+
+// A xorshift pseudo-random number generator, which makes test inputs reproducible. `state` must not be zero.
+inline u64 next_random(u64& state)
+{
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
+}